@@ -11,6 +11,81 @@
 #include <stdlib.h>
 #include "dvbdevice.h"
 
+#define AUDIOPACKETPOOL 64 // the maximum number of unused packets kept for later use
+
+// --- cAudioPacket ----------------------------------------------------------
+
+cMutex cAudioPacket::mutex;
+cAudioPacket *cAudioPacket::pool = NULL;
+int cAudioPacket::poolSize = 0;
+
+cAudioPacket::cAudioPacket(void)
+{
+  nextFree = NULL;
+  refs = 0;
+  data = NULL;
+  size = length = 0;
+  id = 0;
+}
+
+cAudioPacket::~cAudioPacket()
+{
+  free(data);
+}
+
+cAudioPacket *cAudioPacket::New(const uchar *Data, int Length, uchar Id)
+{
+  cAudioPacket *Packet = NULL;
+  mutex.Lock();
+  if (pool) {
+     Packet = pool;
+     pool = Packet->nextFree;
+     poolSize--;
+     }
+  mutex.Unlock();
+  if (!Packet)
+     Packet = new cAudioPacket;
+  if (Packet->size < Length) {
+     free(Packet->data);
+     Packet->data = MALLOC(uchar, Length);
+     Packet->size = Packet->data ? Length : 0;
+     if (!Packet->data) {
+        esyslog("ERROR: can't allocate audio packet");
+        delete Packet;
+        return NULL;
+        }
+     }
+  memcpy(Packet->data, Data, Length);
+  Packet->length = Length;
+  Packet->id = Id;
+  Packet->refs = 1;
+  return Packet;
+}
+
+void cAudioPacket::Ref(void)
+{
+  cMutexLock MutexLock(&mutex);
+  refs++;
+}
+
+void cAudioPacket::Unref(void)
+{
+  mutex.Lock();
+  if (--refs > 0) {
+     mutex.Unlock();
+     return;
+     }
+  if (poolSize < AUDIOPACKETPOOL) {
+     nextFree = pool;
+     pool = this;
+     poolSize++;
+     mutex.Unlock();
+     return;
+     }
+  mutex.Unlock();
+  delete this;
+}
+
 // --- cAudio ----------------------------------------------------------------
 
 cAudio::cAudio(void)
@@ -22,28 +97,91 @@ cAudio::~cAudio()
 {
 }
 
+void cAudio::PlayPackets(cAudioPacket **Packets, int Count)
+{
+  for (int i = 0; i < Count; i++)
+      Play(Packets[i]->Data(), Packets[i]->Length(), Packets[i]->Id());
+}
+
 // --- cAudios ---------------------------------------------------------------
 
 cAudios Audios;
 
+cAudios::cAudios(void)
+{
+  batchSize = 0;
+  batching = 0;
+}
+
+void cAudios::Flush(void)
+{
+  // 'mutex' must be locked!
+  if (batchSize) {
+     for (cAudio *audio = First(); audio; audio = Next(audio)) {
+         if (audio->PlaysPackets())
+            audio->PlayPackets(batch, batchSize);
+         }
+     for (int i = 0; i < batchSize; i++)
+         batch[i]->Unref();
+     batchSize = 0;
+     }
+}
+
 void cAudios::PlayAudio(const uchar *Data, int Length, uchar Id)
 {
-  for (cAudio *audio = First(); audio; audio = Next(audio))
-      audio->Play(Data, Length, Id);
+  if (!First())
+     return; // nobody's listening
+  cMutexLock MutexLock(&mutex);
+  bool PlaysPackets = false;
+  for (cAudio *audio = First(); audio; audio = Next(audio)) {
+      if (audio->PlaysPackets())
+         PlaysPackets = true;
+      else
+         audio->Play(Data, Length, Id);
+      }
+  if (PlaysPackets) {
+     cAudioPacket *Packet = cAudioPacket::New(Data, Length, Id);
+     if (Packet) {
+        batch[batchSize++] = Packet;
+        if (!batching || batchSize >= MAXAUDIOBATCH)
+           Flush();
+        }
+     }
 }
 
 void cAudios::MuteAudio(bool On)
 {
+  cMutexLock MutexLock(&mutex);
+  Flush();
   for (cAudio *audio = First(); audio; audio = Next(audio))
       audio->Mute(On);
 }
 
 void cAudios::ClearAudio(void)
 {
+  cMutexLock MutexLock(&mutex);
+  for (int i = 0; i < batchSize; i++)
+      batch[i]->Unref();
+  batchSize = 0;
   for (cAudio *audio = First(); audio; audio = Next(audio))
       audio->Clear();
 }
 
+// --- cAudioBatch -----------------------------------------------------------
+
+cAudioBatch::cAudioBatch(void)
+{
+  cMutexLock MutexLock(&Audios.mutex);
+  Audios.batching++;
+}
+
+cAudioBatch::~cAudioBatch()
+{
+  cMutexLock MutexLock(&Audios.mutex);
+  if (--Audios.batching == 0)
+     Audios.Flush();
+}
+
 // --- cExternalAudio --------------------------------------------------------
 
 cExternalAudio::cExternalAudio(const char *Command)
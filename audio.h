@@ -13,6 +13,39 @@
 #include "thread.h"
 #include "tools.h"
 
+#define MAXAUDIOBATCH 32 // the maximum number of audio packets delivered at once
+
+class cAudioPacket {
+  friend class cAudios;
+private:
+  static cMutex mutex;
+  static cAudioPacket *pool;
+  static int poolSize;
+  cAudioPacket *nextFree;
+  int refs;
+  uchar *data;
+  int size;
+  int length;
+  uchar id;
+  cAudioPacket(void);
+  ~cAudioPacket();
+  static cAudioPacket *New(const uchar *Data, int Length, uchar Id);
+public:
+  const uchar *Data(void) const { return data; }
+       ///< Returns the complete PES audio packet.
+  int Length(void) const { return length; }
+  uchar Id(void) const { return id; }
+       ///< Returns the type of audio data this packet holds.
+  void Ref(void);
+       ///< Keeps this packet alive beyond the call to cAudio::PlayPackets(). A
+       ///< cAudio that wants to process the packet later (for instance in a
+       ///< separate thread) must call Ref() before returning from PlayPackets(),
+       ///< and Unref() once it is done with the packet. The data of a packet must never
+       ///< be modified, since it is shared by all cAudio objects.
+  void Unref(void);
+       ///< Releases a packet previously kept by a call to Ref().
+  };
+
 class cAudio : public cListObject {
 protected:
   cAudio(void);
@@ -24,6 +57,18 @@ public:
        ///< be copied and processed in a separate thread. The Data is always a
        ///< complete PES audio packet. Id indicates the type of audio data this
        ///< packet holds.
+       ///< A cAudio that processes the data in a separate thread should rather
+       ///< implement PlayPackets() and PlaysPackets(), which avoids having to
+       ///< copy the data.
+  virtual bool PlaysPackets(void) { return false; }
+       ///< Returns true if this cAudio implements PlayPackets(), in which case
+       ///< Play() is never called. Otherwise Play() is called directly with the
+       ///< caller's data, without making a packet of it.
+  virtual void PlayPackets(cAudioPacket **Packets, int Count);
+       ///< Plays the given Packets. Must return as soon as possible. Packets
+       ///< that can't be processed immediately must be kept by calling their
+       ///< Ref() function. The default implementation calls Play() with the
+       ///< data of each packet.
   virtual void Mute(bool On) = 0;
        ///< Immediately sets the audio device to be silent (On==true) or to
        ///< normal replay (On==false).
@@ -32,14 +77,35 @@ public:
   };
 
 class cAudios : public cList<cAudio> {
+  friend class cAudioBatch;
+private:
+  cMutex mutex;
+  cAudioPacket *batch[MAXAUDIOBATCH];
+  int batchSize;
+  int batching;
+  void Flush(void);
 public:
+  cAudios(void);
   void PlayAudio(const uchar *Data, int Length, uchar Id);
+       ///< Hands the given PES audio packet to all cAudio objects. The data is
+       ///< only copied if there are cAudio objects that play packets, and then
+       ///< at most once, no matter how many of them there are. While a
+       ///< cAudioBatch exists, the packets are collected and delivered together.
   void MuteAudio(bool On);
   void ClearAudio(void);
   };
 
 extern cAudios Audios;
 
+class cAudioBatch {
+public:
+  cAudioBatch(void);
+       ///< Makes cAudios::PlayAudio() collect the audio packets instead of
+       ///< delivering each of them individually.
+  ~cAudioBatch();
+       ///< Delivers the collected audio packets.
+  };
+
 class cExternalAudio : public cAudio {
 private:
   char *command;
@@ -234,6 +234,7 @@ public:
   int PrimaryLimit;
   int DefaultPriority, DefaultLifetime;
   int PausePriority, PauseLifetime;
+  int TimeShiftSize, TimeShiftFile;
   int UseSubtitle;
   int UseVps;
   int VpsMargin;
@@ -241,6 +242,7 @@ public:
   int VideoDisplayFormat;
   int VideoFormat;
   int UpdateChannels;
+  int PreTuning;
   int UseDolbyDigital;
   int ChannelInfoPos;
   int ChannelInfoTime;
@@ -256,11 +258,15 @@ public:
   int FontFixSize;
   int MaxVideoFileSize;
   int SplitEditedFiles;
+  int EditingJobs;
+  int EditingBandwidth;
+  int EditingYieldLimit;
   int MinEventTimeout, MinUserInactivity;
   time_t NextWakeupTime;
   int MultiSpeedMode;
   int ShowReplayMode;
   int ResumeID;
+  int ReplayPrefetch;
   int CurrentChannel;
   int CurrentVolume;
   int CurrentDolby;
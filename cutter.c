@@ -8,11 +8,18 @@
  */
 
 #include "cutter.h"
+#include "recorder.h"
 #include "recording.h"
 #include "remux.h"
 #include "thread.h"
 #include "videodir.h"
 
+#define SIZEUPDATEINTERVAL  10 // seconds between updates of the edited version's size in the list of recordings
+
+#define MAXCOPYSPAN  MEGABYTE(16) // the maximum number of bytes copied from the original recording in one go
+
+#define YIELDDELAY  100 // ms to wait while a recorder's buffer is too full
+
 // --- cCuttingThread --------------------------------------------------------
 
 class cCuttingThread : public cThread {
@@ -22,6 +29,16 @@ private:
   cFileName *fromFileName, *toFileName;
   cIndexFile *fromIndex, *toIndex;
   cMarks fromMarks, toMarks;
+  char *toRecordingName;
+  int spanOffset, spanLength;
+  int cloneBlockSize;
+  int brokenLinkOffset, brokenLinkLength;
+  bool CopySpan(void);
+  bool CloneSpan(void);
+  bool WritePadding(int Length);
+  cTimeMs throttleTimer;
+  uint64_t throttleBytes;
+  void Throttle(int Bytes);
 protected:
   virtual void Action(void);
 public:
@@ -37,6 +54,7 @@ cCuttingThread::cCuttingThread(const char *FromFileName, const char *ToFileName)
   fromFile = toFile = NULL;
   fromFileName = toFileName = NULL;
   fromIndex = toIndex = NULL;
+  toRecordingName = strdup(ToFileName);
   if (fromMarks.Load(FromFileName) && fromMarks.Count()) {
      fromFileName = new cFileName(FromFileName, false, true);
      toFileName = new cFileName(ToFileName, true, true);
@@ -56,10 +74,96 @@ cCuttingThread::~cCuttingThread()
   delete toFileName;
   delete fromIndex;
   delete toIndex;
+  free(toRecordingName);
+}
+
+void cCuttingThread::Throttle(int Bytes)
+{
+  // Let's not get in the way of any ongoing recordings:
+  if (Setup.EditingYieldLimit && cRecorder::MaxBufferFillLevel() >= Setup.EditingYieldLimit) {
+     dsyslog("editing process yields to recordings");
+     do {
+        cCondWait::SleepMs(YIELDDELAY);
+        } while (Running() && cRecorder::MaxBufferFillLevel() >= Setup.EditingYieldLimit);
+     throttleTimer.Set();
+     throttleBytes = 0;
+     }
+  // Limit the bandwidth:
+  if (Setup.EditingBandwidth) {
+     throttleBytes += Bytes;
+     int64_t Delay = int64_t(throttleBytes * 1000 / MEGABYTE(Setup.EditingBandwidth)) - int64_t(throttleTimer.Elapsed());
+     if (Delay > 0)
+        cCondWait::SleepMs(Delay);
+     if (throttleTimer.Elapsed() > 1000) {
+        throttleTimer.Set();
+        throttleBytes = 0;
+        }
+     }
+}
+
+bool cCuttingThread::CopySpan(void)
+{
+  if (spanLength) {
+     if (toFile->CopyFrom(fromFile, spanOffset, spanLength) != spanLength)
+        return false;
+     spanLength = 0;
+     }
+  return true;
+}
+
+bool cCuttingThread::WritePadding(int Length)
+{
+  uchar buffer[Length];
+  memset(buffer, 0x00, Length);
+  if (Length >= 6) {
+     // an MPEG padding stream packet:
+     int l = Length - 6;
+     buffer[2] = 0x01;
+     buffer[3] = 0xBE;
+     buffer[4] = l >> 8;
+     buffer[5] = l & 0xFF;
+     memset(buffer + 6, 0xFF, l);
+     }
+  return toFile->Write(buffer, Length) == Length;
+}
+
+bool cCuttingThread::CloneSpan(void)
+{
+  if (spanLength) {
+     // The file starts at the block boundary in front of the first frame:
+     int Gap = spanOffset % cloneBlockSize;
+     if (toFile->CloneFrom(fromFile, spanOffset - Gap, Gap + spanLength) != Gap + spanLength)
+        return false;
+     // The bytes in front of the first frame belong to whatever preceded it in the
+     // original recording, so let's overwrite them:
+     if (Gap && (toFile->Seek(0, SEEK_SET) != 0 || !WritePadding(Gap)))
+        return false;
+     if (brokenLinkLength > 0) {
+        uchar buffer[MAXFRAMESIZE];
+        int Offset = spanOffset - Gap + brokenLinkOffset;
+        if (fromFile->Seek(Offset, SEEK_SET) != Offset)
+           return false;
+        int len = ReadFrame(fromFile, buffer, brokenLinkLength, sizeof(buffer));
+        if (len < 0)
+           return false;
+        cRemux::SetBrokenLink(buffer, len);
+        if (toFile->Seek(brokenLinkOffset, SEEK_SET) != brokenLinkOffset || toFile->Write(buffer, len) != len)
+           return false;
+        brokenLinkLength = 0;
+        }
+     if (toFile->Seek(Gap + spanLength, SEEK_SET) != Gap + spanLength)
+        return false;
+     spanLength = 0;
+     }
+  return true;
 }
 
 void cCuttingThread::Action(void)
 {
+  SetPriority(19);
+  SetIOPriority(7);
+  throttleTimer.Set();
+  throttleBytes = 0;
   cMark *Mark = fromMarks.First();
   if (Mark) {
      fromFile = fromFileName->Open();
@@ -67,9 +171,19 @@ void cCuttingThread::Action(void)
      if (!fromFile || !toFile)
         return;
      fromFile->SetReadAhead(MEGABYTE(20));
+     // If the edited version can share the file system's extents with the original
+     // recording, every span of frames goes into a file of its own, which starts at the
+     // block boundary in front of the span's first frame. That way no data needs to be
+     // copied at all, and only the broken link flags and the index need to be written.
+     cloneBlockSize = toFile->CloneBlockSize(fromFile);
+     if (cloneBlockSize)
+        isyslog("editing by sharing extents (block size %d)", cloneBlockSize);
+     brokenLinkLength = 0;
      int Index = Mark->position;
      Mark = fromMarks.Next(Mark);
      int FileSize = 0;
+     int PreviousFilesSizeMB = 0;
+     time_t LastSizeUpdate = time(NULL);
      int CurrentFileNumber = 0;
      int LastIFrame = 0;
      toMarks.Add(0);
@@ -77,6 +191,7 @@ void cCuttingThread::Action(void)
      uchar buffer[MAXFRAMESIZE];
      bool LastMark = false;
      bool cutIn = true;
+     spanLength = 0;
      while (Running()) {
            uchar FileNumber;
            int FileOffset, Length;
@@ -86,60 +201,102 @@ void cCuttingThread::Action(void)
 
            AssertFreeDiskSpace(-1);
 
-           // Read one frame:
+           // Locate the next frame:
 
-           if (fromIndex->Get(Index++, &FileNumber, &FileOffset, &PictureType, &Length)) {
-              if (FileNumber != CurrentFileNumber) {
-                 fromFile = fromFileName->SetOffset(FileNumber, FileOffset);
-                 fromFile->SetReadAhead(MEGABYTE(20));
-                 CurrentFileNumber = FileNumber;
-                 }
-              if (fromFile) {
-                 int len = ReadFrame(fromFile, buffer,  Length, sizeof(buffer));
-                 if (len < 0) {
-                    error = "ReadFrame";
-                    break;
-                    }
-                 if (len != Length) {
-                    CurrentFileNumber = 0; // this re-syncs in case the frame was larger than the buffer
-                    Length = len;
-                    }
-                 }
-              else {
-                 error = "fromFile";
-                 break;
-                 }
-              }
-           else {
+           if (!fromIndex->Get(Index++, &FileNumber, &FileOffset, &PictureType, &Length)) {
               // Error, unless we're past the last cut-in and there's no cut-out
               if (Mark || LastMark)
                  error = "index";
               break;
               }
+           if (PictureType == I_FRAME && LastMark) // edited version shall end before next I-frame
+              break;
+           bool NextFile = PictureType == I_FRAME && FileSize > MEGABYTE(Setup.MaxVideoFileSize); // every file shall start with an I_FRAME
+           bool BrokenLink = PictureType == I_FRAME && cutIn;
+
+           Throttle(cloneBlockSize ? 0 : max(Length, 0));
 
-           // Write one frame:
+           // Copy the frames collected so far, unless this frame simply continues them:
 
-           if (PictureType == I_FRAME) { // every file shall start with an I_FRAME
-              if (LastMark) // edited version shall end before next I-frame
+           if (spanLength && (FileNumber != CurrentFileNumber || NextFile || !cloneBlockSize && (FileOffset != spanOffset + spanLength || Length < 0 || spanLength + Length > MAXCOPYSPAN || BrokenLink))) {
+              if (!(cloneBlockSize ? CloneSpan() : CopySpan())) {
+                 error = "copy";
                  break;
-              if (FileSize > MEGABYTE(Setup.MaxVideoFileSize)) {
+                 }
+              }
+           if (FileNumber != CurrentFileNumber) {
+              fromFile = fromFileName->SetOffset(FileNumber, FileOffset);
+              if (!fromFile) {
+                 error = "fromFile";
+                 break;
+                 }
+              fromFile->SetReadAhead(MEGABYTE(20));
+              CurrentFileNumber = FileNumber;
+              }
+           if (PictureType == I_FRAME)
+              LastIFrame = 0;
+
+           if (cloneBlockSize) {
+              if (Length < 0)
+                 Length = fromFile->Seek(0, SEEK_END) - FileOffset;
+              if (!spanLength) {
+                 if (FileSize) {
+                    toFile = toFileName->NextFile();
+                    if (!toFile) {
+                       error = "toFile 1";
+                       break;
+                       }
+                    PreviousFilesSizeMB += FileSize / MEGABYTE(1);
+                    }
+                 spanOffset = FileOffset;
+                 FileSize = FileOffset % cloneBlockSize;
+                 }
+              if (BrokenLink) {
+                 brokenLinkOffset = FileSize;
+                 brokenLinkLength = Length;
+                 cutIn = false;
+                 }
+              spanLength += Length;
+              }
+           else {
+              if (NextFile) {
                  toFile = toFileName->NextFile();
                  if (!toFile) {
                     error = "toFile 1";
                     break;
                     }
+                 PreviousFilesSizeMB += FileSize / MEGABYTE(1);
                  FileSize = 0;
                  }
-              LastIFrame = 0;
 
-              if (cutIn) {
-                 cRemux::SetBrokenLink(buffer, Length);
-                 cutIn = false;
+              // Only the first frame after a cut-in (and a frame of unknown length) needs to be
+              // read into our buffer - everything else is copied in large spans by the kernel:
+
+              if (BrokenLink || Length < 0) {
+                 if (fromFile->Seek(FileOffset, SEEK_SET) != FileOffset) {
+                    error = "fromFile seek";
+                    break;
+                    }
+                 int len = ReadFrame(fromFile, buffer,  Length, sizeof(buffer));
+                 if (len < 0) {
+                    error = "ReadFrame";
+                    break;
+                    }
+                 Length = len;
+                 if (BrokenLink) {
+                    cRemux::SetBrokenLink(buffer, Length);
+                    cutIn = false;
+                    }
+                 if (toFile->Write(buffer, Length) < 0) {
+                    error = "safe_write";
+                    break;
+                    }
+                 }
+              else {
+                 if (!spanLength)
+                    spanOffset = FileOffset;
+                 spanLength += Length;
                  }
-              }
-           if (toFile->Write(buffer, Length) < 0) {
-              error = "safe_write";
-              break;
               }
            if (!toIndex->Write(PictureType, toFileName->Number(), FileSize)) {
               error = "toIndex";
@@ -162,37 +319,74 @@ void cCuttingThread::Action(void)
                  Mark = fromMarks.Next(Mark);
                  CurrentFileNumber = 0; // triggers SetOffset before reading next frame
                  cutIn = true;
-                 if (Setup.SplitEditedFiles) {
+                 if (Setup.SplitEditedFiles && !cloneBlockSize) { // when sharing extents, every cut-in starts a new file, anyway
+                    if (!CopySpan()) {
+                       error = "copy";
+                       break;
+                       }
                     toFile = toFileName->NextFile();
                     if (!toFile) {
                        error = "toFile 2";
                        break;
                        }
+                    PreviousFilesSizeMB += FileSize / MEGABYTE(1);
                     FileSize = 0;
                     }
                  }
               else
                  LastMark = true;
               }
+
+           // Let the list of recordings know how far we've come:
+
+           if (time(NULL) - LastSizeUpdate > SIZEUPDATEINTERVAL) {
+              Recordings.UpdateFileSize(toRecordingName, PreviousFilesSizeMB + FileSize / MEGABYTE(1), toIndex->Last() + 1);
+              LastSizeUpdate = time(NULL);
+              }
            }
+     if (!error && !(cloneBlockSize ? CloneSpan() : CopySpan()))
+        error = "copy";
+     Recordings.UpdateFileSize(toRecordingName, PreviousFilesSizeMB + FileSize / MEGABYTE(1), toIndex->Last() + 1);
      Recordings.TouchUpdate();
      }
   else
      esyslog("no editing marks found!");
 }
 
+// --- cCuttingJob ----------------------------------------------------------
+
+class cCuttingJob : public cListObject {
+public:
+  char *fileName;
+  char *editedVersionName;
+  cCuttingThread *cuttingThread;
+  cCuttingJob(const char *FileName, const char *EditedVersionName);
+  ~cCuttingJob();
+  };
+
+cCuttingJob::cCuttingJob(const char *FileName, const char *EditedVersionName)
+{
+  fileName = strdup(FileName);
+  editedVersionName = strdup(EditedVersionName);
+  cuttingThread = NULL;
+}
+
+cCuttingJob::~cCuttingJob()
+{
+  delete cuttingThread;
+  free(fileName);
+  free(editedVersionName);
+}
+
 // --- cCutter ---------------------------------------------------------------
 
-char *cCutter::editedVersionName = NULL;
-cCuttingThread *cCutter::cuttingThread = NULL;
+cList<cCuttingJob> cCutter::jobs;
 bool cCutter::error = false;
 bool cCutter::ended = false;
 
 bool cCutter::Start(const char *FileName)
 {
-  if (!cuttingThread) {
-     error = false;
-     ended = false;
+  if (!Active(FileName)) {
      cRecording Recording(FileName);
      const char *evn = Recording.PrefixFileName('%');
      if (evn && RemoveVideoFile(evn) && MakeDirs(evn, true)) {
@@ -208,45 +402,72 @@ bool cCutter::Start(const char *FileName)
            }
         free(s);
         // XXX
-        editedVersionName = strdup(evn);
         Recording.WriteInfo();
-        Recordings.AddByName(editedVersionName, false);
-        cuttingThread = new cCuttingThread(FileName, editedVersionName);
+        Recordings.AddByName(evn, false);
+        jobs.Add(new cCuttingJob(FileName, evn));
+        Process(); // starts the job if possible
         return true;
         }
      }
   return false;
 }
 
-void cCutter::Stop(void)
+void cCutter::Finish(cCuttingJob *Job, bool Interrupted)
 {
-  bool Interrupted = cuttingThread && cuttingThread->Active();
-  const char *Error = cuttingThread ? cuttingThread->Error() : NULL;
-  delete cuttingThread;
-  cuttingThread = NULL;
-  if ((Interrupted || Error) && editedVersionName) {
+  const char *Error = Job->cuttingThread ? Job->cuttingThread->Error() : NULL;
+  delete Job->cuttingThread;
+  Job->cuttingThread = NULL;
+  if (Interrupted || Error) {
      if (Interrupted)
         isyslog("editing process has been interrupted");
      if (Error)
         esyslog("ERROR: '%s' during editing process", Error);
-     RemoveVideoFile(editedVersionName); //XXX what if this file is currently being replayed?
-     Recordings.DelByName(editedVersionName);
+     RemoveVideoFile(Job->editedVersionName); //XXX what if this file is currently being replayed?
+     Recordings.DelByName(Job->editedVersionName);
      }
+  if (Error)
+     error = true;
+  else if (!Interrupted)
+     cRecordingUserCommand::InvokeCommand(RUC_EDITEDRECORDING, Job->editedVersionName);
+  jobs.Del(Job);
 }
 
-bool cCutter::Active(void)
+void cCutter::Stop(void)
 {
-  if (cuttingThread) {
-     if (cuttingThread->Active())
-        return true;
-     error = cuttingThread->Error();
-     Stop();
-     if (!error)
-        cRecordingUserCommand::InvokeCommand(RUC_EDITEDRECORDING, editedVersionName);
-     free(editedVersionName);
-     editedVersionName = NULL;
-     ended = true;
-     }
+  while (cCuttingJob *Job = jobs.First())
+        Finish(Job, true);
+}
+
+void cCutter::Process(void)
+{
+  int Running = 0;
+  for (cCuttingJob *Job = jobs.First(); Job; ) {
+      cCuttingJob *Next = jobs.Next(Job);
+      if (Job->cuttingThread) {
+         if (Job->cuttingThread->Active())
+            Running++;
+         else {
+            Finish(Job, false);
+            ended = true;
+            }
+         }
+      Job = Next;
+      }
+  for (cCuttingJob *Job = jobs.First(); Job && Running < Setup.EditingJobs; Job = jobs.Next(Job)) {
+      if (!Job->cuttingThread) {
+         Job->cuttingThread = new cCuttingThread(Job->fileName, Job->editedVersionName);
+         Running++;
+         }
+      }
+}
+
+bool cCutter::Active(const char *FileName)
+{
+  Process();
+  for (cCuttingJob *Job = jobs.First(); Job; Job = jobs.Next(Job)) {
+      if (!FileName || strcmp(Job->fileName, FileName) == 0)
+         return true;
+      }
   return false;
 }
 
@@ -10,18 +10,33 @@
 #ifndef __CUTTER_H
 #define __CUTTER_H
 
-class cCuttingThread;
+#include "tools.h"
+
+#define MAXEDITINGJOBS 4 // the maximum number of recordings that can be edited at the same time
+
+class cCuttingJob;
 
 class cCutter {
 private:
-  static char *editedVersionName;
-  static cCuttingThread *cuttingThread;
+  static cList<cCuttingJob> jobs;
   static bool error;
   static bool ended;
+  static void Finish(cCuttingJob *Job, bool Interrupted);
 public:
   static bool Start(const char *FileName);
+       ///< Queues the recording with the given FileName for editing. Up to
+       ///< Setup.EditingJobs recordings are edited at the same time, any further
+       ///< ones are started as soon as a running editing process has ended.
+       ///< Returns false if the edited version can't be set up, or if the
+       ///< given recording is already being edited.
   static void Stop(void);
-  static bool Active(void);
+       ///< Stops all running and queued editing processes.
+  static void Process(void);
+       ///< Cleans up after editing processes that have ended and starts queued
+       ///< ones. Must be called periodically.
+  static bool Active(const char *FileName = NULL);
+       ///< Returns true if any recording (or the one with the given FileName)
+       ///< is being edited or is waiting to be edited.
   static bool Error(void);
   static bool Ended(void);
   };
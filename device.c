@@ -18,6 +18,7 @@
 #include "receiver.h"
 #include "status.h"
 #include "transfer.h"
+#include "zaptrace.h"
 
 // --- cLiveSubtitle ---------------------------------------------------------
 
@@ -252,6 +253,7 @@ cDevice::cDevice(void)
 
   for (int i = 0; i < MAXRECEIVERS; i++)
       receiver[i] = NULL;
+  receiveTime = 0;
 
   if (numDevices < MAXDEVICES)
      device[numDevices++] = this;
@@ -405,6 +407,7 @@ cDevice *cDevice::GetDevice(const cChannel *Channel, int Priority, bool LiveView
              // to their individual severity, where the one listed first will make the most
              // difference, because it results in the most significant bit of the result.
              uint32_t imp = 0;
+             imp <<= 1; imp |= LiveView && Setup.PreTuning ? !device[i]->IsTunedToTransponder(Channel) : 0;          // prefer a device that has been tuned to this transponder in advance
              imp <<= 1; imp |= LiveView ? !device[i]->IsPrimaryDevice() || ndr : 0;                                  // prefer the primary device for live viewing if we don't need to detach existing receivers
              imp <<= 1; imp |= !device[i]->Receiving() && (device[i] != cTransferControl::ReceiverDevice() || device[i]->IsPrimaryDevice()) || ndr; // use receiving devices if we don't need to detach existing receivers, but avoid primary device in local transfer mode
              imp <<= 1; imp |= device[i]->Receiving();                                                               // avoid devices that are receiving
@@ -429,6 +432,8 @@ cDevice *cDevice::GetDevice(const cChannel *Channel, int Priority, bool LiveView
       if (!NumUsableSlots)
          break; // no CAM necessary, so just one loop over the devices
       }
+  if (LiveView)
+     cZapTrace::Mark(zpDevice);
   if (d) {
      if (NeedsDetachReceivers)
         d->DetachAllReceivers();
@@ -440,6 +445,8 @@ cDevice *cDevice::GetDevice(const cChannel *Channel, int Priority, bool LiveView
               d->CamSlot()->Assign(NULL);
            s->Assign(d);
            }
+        if (LiveView)
+           cZapTrace::Mark(zpCam);
         }
      else if (d->CamSlot() && !d->CamSlot()->IsDecrypting())
         d->CamSlot()->Assign(NULL);
@@ -688,6 +695,42 @@ void cDevice::Detach(cFilter *Filter)
      sectionHandler->Detach(Filter);
 }
 
+cString cDevice::SectionStatistics(void)
+{
+  cString s = "";
+  for (int i = 0; i < numDevices; i++) {
+      if (device[i] && device[i]->sectionHandler) {
+         int Hits, Misses, Entries;
+         device[i]->sectionHandler->GetStatistics(Hits, Misses, Entries);
+         s = cString::sprintf("%sdevice %d: %d repeated, %d processed (%d%% repeated), %d cached\n", *s, device[i]->CardIndex() + 1, Hits, Misses, Hits + Misses ? Hits * 100 / (Hits + Misses) : 0, Entries);
+         }
+      }
+  if (!**s)
+     s = "no section handlers\n";
+  return s;
+}
+
+void cDevice::ClearSectionStatistics(void)
+{
+  for (int i = 0; i < numDevices; i++) {
+      if (device[i] && device[i]->sectionHandler)
+         device[i]->sectionHandler->ClearStatistics();
+      }
+}
+
+void cDevice::FlushEit(void)
+{
+  for (int i = 0; i < numDevices; i++) {
+      if (device[i] && device[i]->eitFilter)
+         device[i]->eitFilter->Flush();
+      }
+}
+
+bool cDevice::EitComplete(void)
+{
+  return eitFilter && eitFilter->Complete();
+}
+
 bool cDevice::ProvidesSource(int Source) const
 {
   return false;
@@ -780,7 +823,12 @@ eSetChannelResult cDevice::SetChannel(const cChannel *Channel, bool LiveView)
      DELETENULL(dvbSubtitleConverter);
      }
 
-  cDevice *Device = (LiveView && IsPrimaryDevice()) ? GetDevice(Channel, 0, LiveView) : this;
+  cDevice *Device = this;
+  if (LiveView && IsPrimaryDevice()) {
+     cZapTrace::Start(Channel);
+     Device = GetDevice(Channel, 0, LiveView);
+     cZapTrace::SetDevice(Device);
+     }
 
   bool NeedsTransferMode = Device != this;
 
@@ -813,10 +861,13 @@ eSetChannelResult cDevice::SetChannel(const cChannel *Channel, bool LiveView)
      if (camSlot)
         camSlot->AddChannel(Channel);
      if (SetChannelDevice(Channel, LiveView)) {
+        if (HasLock())
+           cZapTrace::Mark(zpLock, CardIndex()); // the device was already tuned to this transponder
         // Start section handling:
         if (sectionHandler) {
            sectionHandler->SetChannel(Channel);
            sectionHandler->SetStatus(true);
+           cZapTrace::Mark(zpSections, CardIndex());
            }
         // Start decrypting any PIDs that might have been set in SetChannelDevice():
         if (camSlot)
@@ -1344,6 +1395,7 @@ int cDevice::PlayPes(const uchar *Data, int Length, bool VideoOnly)
         dvbSubtitleConverter->Reset();
      return 0;
      }
+  cAudioBatch AudioBatch; // hands all audio packets of this call to the cAudio objects at once
   int Result = 0;
   if (pesAssembler->Length()) {
      // Make sure we have a complete PES header:
@@ -1427,6 +1479,7 @@ void cDevice::Action(void)
            uchar *b = NULL;
            if (GetTSPacket(b)) {
               if (b) {
+                 receiveTime = cTimeMs::Now();
                  int Pid = (((uint16_t)b[1] & PID_MASK_HI) << 8) | b[2];
                  // Check whether the TS packets are scrambled:
                  bool DetachReceivers = false;
@@ -1448,6 +1501,8 @@ void cDevice::Action(void)
                           }
                        }
                     }
+                 if (cZapTrace::WantsPid(CardIndex(), Pid))
+                    cZapTrace::Mark(zpVideo, CardIndex());
                  // Distribute the packet to all attached receivers:
                  Lock();
                  for (int i = 0; i < MAXRECEIVERS; i++) {
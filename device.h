@@ -326,6 +326,16 @@ public:
        ///< Attaches the given filter to this device.
   void Detach(cFilter *Filter);
        ///< Detaches the given filter from this device.
+  static cString SectionStatistics(void);
+       ///< Returns how many of the sections received by each device have been
+       ///< dropped as unchanged repetitions and how many have been processed.
+  static void ClearSectionStatistics(void);
+  static void FlushEit(void);
+       ///< Makes the EIT filters of all devices enter any schedule data they
+       ///< have been holding back for too long into the EPG.
+  bool EitComplete(void);
+       ///< Returns true if this device has received all sections of the EIT
+       ///< schedule tables of the transponder it is currently tuned to.
 
 // Common Interface facilities:
 
@@ -575,6 +585,7 @@ public:
 private:
   cMutex mutexReceiver;
   cReceiver *receiver[MAXRECEIVERS];
+  uint64_t receiveTime;
 public:
   int Priority(void) const;
       ///< Returns the priority of the current receiving session (0..MAXPRIORITY),
@@ -602,6 +613,10 @@ public:
        ///< Detaches the given receiver from this device.
   void DetachAll(int Pid);
        ///< Detaches all receivers from this device for this pid.
+  uint64_t ReceiveTime(void) const { return receiveTime; }
+       ///< Returns the time (in ms, as given by cTimeMs::Now()) at which the TS
+       ///< packet that is currently being delivered to the receivers has been
+       ///< read from the DVR.
   void DetachAllReceivers(void);
        ///< Detaches all receivers from this device.
   };
@@ -9,6 +9,7 @@
 
 #include "dvbdevice.h"
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
 #include <linux/videodev.h>
 #include <linux/dvb/audio.h>
@@ -26,6 +27,7 @@
 #include "receiver.h"
 #include "status.h"
 #include "transfer.h"
+#include "zaptrace.h"
 
 #define DO_REC_AND_PLAY_ON_PRIMARY_DEVICE 1
 #define DO_MULTIPLE_RECORDINGS 1
@@ -66,12 +68,118 @@ static int DvbOpen(const char *Name, int n, int Mode, bool ReportError = false)
   return fd;
 }
 
+// --- cDvbFrontendDevice ----------------------------------------------------
+
+cDvbFrontendDevice::cDvbFrontendDevice(int Fd_Frontend)
+{
+  fd_frontend = Fd_Frontend;
+  if (pipe(wakeupPipe) == 0) {
+     fcntl(wakeupPipe[0], F_SETFL, O_NONBLOCK);
+     fcntl(wakeupPipe[1], F_SETFL, O_NONBLOCK);
+     }
+  else {
+     LOG_ERROR;
+     wakeupPipe[0] = wakeupPipe[1] = -1;
+     }
+}
+
+cDvbFrontendDevice::~cDvbFrontendDevice()
+{
+  // The frontend device itself is not closed here - see ~cDvbDevice().
+  if (wakeupPipe[0] >= 0) {
+     close(wakeupPipe[0]);
+     close(wakeupPipe[1]);
+     }
+}
+
+bool cDvbFrontendDevice::GetInfo(dvb_frontend_info &Info)
+{
+  return ioctl(fd_frontend, FE_GET_INFO, &Info) >= 0;
+}
+
+bool cDvbFrontendDevice::SetVoltage(fe_sec_voltage_t Voltage)
+{
+  if (ioctl(fd_frontend, FE_SET_VOLTAGE, Voltage) < 0) {
+     LOG_ERROR;
+     return false;
+     }
+  return true;
+}
+
+bool cDvbFrontendDevice::SetTone(fe_sec_tone_mode_t Tone)
+{
+  if (ioctl(fd_frontend, FE_SET_TONE, Tone) < 0) {
+     LOG_ERROR;
+     return false;
+     }
+  return true;
+}
+
+bool cDvbFrontendDevice::SendBurst(fe_sec_mini_cmd_t Burst)
+{
+  if (ioctl(fd_frontend, FE_DISEQC_SEND_BURST, Burst) < 0) {
+     LOG_ERROR;
+     return false;
+     }
+  return true;
+}
+
+bool cDvbFrontendDevice::SendDiseqc(dvb_diseqc_master_cmd &Command)
+{
+  if (ioctl(fd_frontend, FE_DISEQC_SEND_MASTER_CMD, &Command) < 0) {
+     LOG_ERROR;
+     return false;
+     }
+  return true;
+}
+
+bool cDvbFrontendDevice::SetParameters(dvb_frontend_parameters &Parameters)
+{
+  return ioctl(fd_frontend, FE_SET_FRONTEND, &Parameters) >= 0;
+}
+
+bool cDvbFrontendDevice::GetStatus(fe_status_t &Status)
+{
+  while (1) {
+        if (ioctl(fd_frontend, FE_READ_STATUS, &Status) != -1)
+           return true;
+        if (errno != EINTR)
+           break;
+        }
+  return false;
+}
+
+bool cDvbFrontendDevice::WaitForEvent(int TimeoutMs)
+{
+  cPoller Poller(fd_frontend);
+  Poller.Add(wakeupPipe[0], false);
+  if (Poller.Poll(TimeoutMs)) {
+     char c;
+     while (read(wakeupPipe[0], &c, 1) == 1)
+           ; // just to clear the pipe
+     bool Event = false;
+     dvb_frontend_event e;
+     while (ioctl(fd_frontend, FE_GET_EVENT, &e) == 0)
+           Event = true; // just to clear the event queue - the caller will read the actual status
+     return Event;
+     }
+  return false;
+}
+
+void cDvbFrontendDevice::Wakeup(void)
+{
+  if (wakeupPipe[1] >= 0 && write(wakeupPipe[1], "", 1) < 0 && errno != EAGAIN)
+     LOG_ERROR;
+}
+
 // --- cDvbTuner -------------------------------------------------------------
 
+#define TUNEPOLLINTERVAL 100 // ms between checks for a tuning timeout
+
 class cDvbTuner : public cThread {
 private:
   enum eTunerStatus { tsIdle, tsSet, tsTuned, tsLocked };
-  int fd_frontend;
+  cDvbFrontend *frontend;
   int cardIndex;
   int tuneTimeout;
   int lockTimeout;
@@ -82,21 +190,21 @@ private:
   eTunerStatus tunerStatus;
   cMutex mutex;
   cCondVar locked;
-  cCondVar newSet;
-  bool GetFrontendStatus(fe_status_t &Status, int TimeoutMs = 0);
   bool SetFrontend(void);
   virtual void Action(void);
 public:
-  cDvbTuner(int Fd_Frontend, int CardIndex, fe_type_t FrontendType);
+  cDvbTuner(cDvbFrontend *Frontend, int CardIndex, fe_type_t FrontendType);
+       ///< Creates a tuner that uses the given Frontend, which will be deleted
+       ///< when the tuner is deleted.
   virtual ~cDvbTuner();
   bool IsTunedTo(const cChannel *Channel) const;
   void Set(const cChannel *Channel, bool Tune);
   bool Locked(int TimeoutMs = 0);
   };
 
-cDvbTuner::cDvbTuner(int Fd_Frontend, int CardIndex, fe_type_t FrontendType)
+cDvbTuner::cDvbTuner(cDvbFrontend *Frontend, int CardIndex, fe_type_t FrontendType)
 {
-  fd_frontend = Fd_Frontend;
+  frontend = Frontend;
   cardIndex = CardIndex;
   frontendType = FrontendType;
   tuneTimeout = 0;
@@ -105,7 +213,7 @@ cDvbTuner::cDvbTuner(int Fd_Frontend, int CardIndex, fe_type_t FrontendType)
   diseqcCommands = NULL;
   tunerStatus = tsIdle;
   if (frontendType == FE_QPSK)
-     CHECK(ioctl(fd_frontend, FE_SET_VOLTAGE, SEC_VOLTAGE_13)); // must explicitly turn on LNB power
+     frontend->SetVoltage(SEC_VOLTAGE_13); // must explicitly turn on LNB power
   SetDescription("tuner on device %d", cardIndex + 1);
   Start();
 }
@@ -113,9 +221,11 @@ cDvbTuner::cDvbTuner(int Fd_Frontend, int CardIndex, fe_type_t FrontendType)
 cDvbTuner::~cDvbTuner()
 {
   tunerStatus = tsIdle;
-  newSet.Broadcast();
+  Cancel(-1);
+  frontend->Wakeup();
   locked.Broadcast();
   Cancel(3);
+  delete frontend;
 }
 
 bool cDvbTuner::IsTunedTo(const cChannel *Channel) const
@@ -130,7 +240,7 @@ void cDvbTuner::Set(const cChannel *Channel, bool Tune)
      tunerStatus = tsSet;
   channel = *Channel;
   lastTimeoutReport = 0;
-  newSet.Broadcast();
+  frontend->Wakeup();
 }
 
 bool cDvbTuner::Locked(int TimeoutMs)
@@ -145,25 +255,6 @@ bool cDvbTuner::Locked(int TimeoutMs)
   return tunerStatus >= tsLocked;
 }
 
-bool cDvbTuner::GetFrontendStatus(fe_status_t &Status, int TimeoutMs)
-{
-  if (TimeoutMs) {
-     cPoller Poller(fd_frontend);
-     if (Poller.Poll(TimeoutMs)) {
-        dvb_frontend_event Event;
-        while (ioctl(fd_frontend, FE_GET_EVENT, &Event) == 0)
-              ; // just to clear the event queue - we'll read the actual status below
-        }
-     }
-  while (1) {
-        if (ioctl(fd_frontend, FE_READ_STATUS, &Status) != -1)
-           return true;
-        if (errno != EINTR)
-           break;
-        }
-  return false;
-}
-
 static unsigned int FrequencyToHz(unsigned int f)
 {
   while (f && f < 1000000)
@@ -190,12 +281,12 @@ bool cDvbTuner::SetFrontend(void)
                   for (char *CurrentAction = NULL; (da = diseqc->Execute(&CurrentAction)) != cDiseqc::daNone; ) {
                       switch (da) {
                         case cDiseqc::daNone:      break;
-                        case cDiseqc::daToneOff:   CHECK(ioctl(fd_frontend, FE_SET_TONE, SEC_TONE_OFF)); break;
-                        case cDiseqc::daToneOn:    CHECK(ioctl(fd_frontend, FE_SET_TONE, SEC_TONE_ON)); break;
-                        case cDiseqc::daVoltage13: CHECK(ioctl(fd_frontend, FE_SET_VOLTAGE, SEC_VOLTAGE_13)); break;
-                        case cDiseqc::daVoltage18: CHECK(ioctl(fd_frontend, FE_SET_VOLTAGE, SEC_VOLTAGE_18)); break;
-                        case cDiseqc::daMiniA:     CHECK(ioctl(fd_frontend, FE_DISEQC_SEND_BURST, SEC_MINI_A)); break;
-                        case cDiseqc::daMiniB:     CHECK(ioctl(fd_frontend, FE_DISEQC_SEND_BURST, SEC_MINI_B)); break;
+                        case cDiseqc::daToneOff:   frontend->SetTone(SEC_TONE_OFF); break;
+                        case cDiseqc::daToneOn:    frontend->SetTone(SEC_TONE_ON); break;
+                        case cDiseqc::daVoltage13: frontend->SetVoltage(SEC_VOLTAGE_13); break;
+                        case cDiseqc::daVoltage18: frontend->SetVoltage(SEC_VOLTAGE_18); break;
+                        case cDiseqc::daMiniA:     frontend->SendBurst(SEC_MINI_A); break;
+                        case cDiseqc::daMiniB:     frontend->SendBurst(SEC_MINI_B); break;
                         case cDiseqc::daCodes: {
                              int n = 0;
                              uchar *codes = diseqc->Codes(n);
@@ -203,7 +294,7 @@ bool cDvbTuner::SetFrontend(void)
                                 struct dvb_diseqc_master_cmd cmd;
                                 memcpy(cmd.msg, codes, min(n, int(sizeof(cmd.msg))));
                                 cmd.msg_len = n;
-                                CHECK(ioctl(fd_frontend, FE_DISEQC_SEND_MASTER_CMD, &cmd));
+                                frontend->SendDiseqc(cmd);
                                 }
                              }
                              break;
@@ -229,9 +320,9 @@ bool cDvbTuner::SetFrontend(void)
                frequency -= Setup.LnbFrequHi;
                tone = SEC_TONE_ON;
                }
-            int volt = (channel.Polarization() == 'v' || channel.Polarization() == 'V' || channel.Polarization() == 'r' || channel.Polarization() == 'R') ? SEC_VOLTAGE_13 : SEC_VOLTAGE_18;
-            CHECK(ioctl(fd_frontend, FE_SET_VOLTAGE, volt));
-            CHECK(ioctl(fd_frontend, FE_SET_TONE, tone));
+            fe_sec_voltage_t volt = (channel.Polarization() == 'v' || channel.Polarization() == 'V' || channel.Polarization() == 'r' || channel.Polarization() == 'R') ? SEC_VOLTAGE_13 : SEC_VOLTAGE_18;
+            frontend->SetVoltage(volt);
+            frontend->SetTone(fe_sec_tone_mode_t(tone));
             }
 
          frequency = abs(frequency); // Allow for C-band, where the frequency is less than the LOF
@@ -280,7 +371,7 @@ bool cDvbTuner::SetFrontend(void)
          esyslog("ERROR: attempt to set channel with unknown DVB frontend type");
          return false;
     }
-  if (ioctl(fd_frontend, FE_SET_FRONTEND, &Frontend) < 0) {
+  if (!frontend->SetParameters(Frontend)) {
      esyslog("ERROR: frontend %d: %m", cardIndex);
      return false;
      }
@@ -293,17 +384,16 @@ void cDvbTuner::Action(void)
   bool LostLock = false;
   fe_status_t Status = (fe_status_t)0;
   while (Running()) {
-        fe_status_t NewStatus;
-        if (GetFrontendStatus(NewStatus, 10))
-           Status = NewStatus;
-        cMutexLock MutexLock(&mutex);
+        int WaitMs = -1; // wait for the next event from the frontend
+        mutex.Lock();
         switch (tunerStatus) {
           case tsIdle:
                break;
           case tsSet:
                tunerStatus = SetFrontend() ? tsTuned : tsIdle;
                Timer.Set(tuneTimeout);
-               continue;
+               Status = (fe_status_t)0; // we'll only trust the status reported after tuning
+               break;
           case tsTuned:
                if (Timer.TimedOut()) {
                   tunerStatus = tsSet;
@@ -312,6 +402,7 @@ void cDvbTuner::Action(void)
                      isyslog("frontend %d timed out while tuning to channel %d, tp %d", cardIndex, channel.Number(), channel.Transponder());
                      lastTimeoutReport = time(NULL);
                      }
+                  mutex.Unlock();
                   continue;
                   }
           case tsLocked:
@@ -320,6 +411,7 @@ void cDvbTuner::Action(void)
                   diseqcCommands = NULL;
                   isyslog("frontend %d was reinitialized", cardIndex);
                   lastTimeoutReport = 0;
+                  mutex.Unlock();
                   continue;
                   }
                else if (Status & FE_HAS_LOCK) {
@@ -327,6 +419,8 @@ void cDvbTuner::Action(void)
                      isyslog("frontend %d regained lock on channel %d, tp %d", cardIndex, channel.Number(), channel.Transponder());
                      LostLock = false;
                      }
+                  if (tunerStatus != tsLocked)
+                     cZapTrace::Mark(zpLock, cardIndex);
                   tunerStatus = tsLocked;
                   locked.Broadcast();
                   lastTimeoutReport = 0;
@@ -337,12 +431,16 @@ void cDvbTuner::Action(void)
                   tunerStatus = tsTuned;
                   Timer.Set(lockTimeout);
                   lastTimeoutReport = 0;
-                  continue;
                   }
           }
-
-        if (tunerStatus != tsTuned)
-           newSet.TimedWait(mutex, 1000);
+        if (tunerStatus == tsTuned)
+           WaitMs = TUNEPOLLINTERVAL; // to detect tuning timeouts
+        mutex.Unlock();
+        // Wait for the frontend to report a change (or a call to Set()):
+        frontend->WaitForEvent(WaitMs);
+        fe_status_t NewStatus;
+        if (frontend->GetStatus(NewStatus))
+           Status = NewStatus;
         }
 }
 
@@ -417,13 +515,16 @@ cDvbDevice::cDvbDevice(int n)
   // We only check the devices that must be present - the others will be checked before accessing them://XXX
 
   if (fd_frontend >= 0) {
+     cDvbFrontend *Frontend = new cDvbFrontendDevice(fd_frontend);
      dvb_frontend_info feinfo;
-     if (ioctl(fd_frontend, FE_GET_INFO, &feinfo) >= 0) {
+     if (Frontend->GetInfo(feinfo)) {
         frontendType = feinfo.type;
-        dvbTuner = new cDvbTuner(fd_frontend, CardIndex(), frontendType);
+        dvbTuner = new cDvbTuner(Frontend, CardIndex(), frontendType);
         }
-     else
+     else {
         LOG_ERROR;
+        delete Frontend;
+        }
      }
   else
      esyslog("ERROR: can't open DVB device %d", n);
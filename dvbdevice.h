@@ -23,6 +23,49 @@
 
 class cDvbTuner;
 
+/// The cDvbFrontend is the interface through which the tuner of a cDvbDevice
+/// accesses the actual frontend hardware. A different implementation (like a
+/// simulated frontend) can be handed to the tuner instead of the real one.
+
+class cDvbFrontend {
+public:
+  virtual ~cDvbFrontend() {}
+  virtual bool GetInfo(dvb_frontend_info &Info) = 0;
+  virtual bool SetVoltage(fe_sec_voltage_t Voltage) = 0;
+  virtual bool SetTone(fe_sec_tone_mode_t Tone) = 0;
+  virtual bool SendBurst(fe_sec_mini_cmd_t Burst) = 0;
+  virtual bool SendDiseqc(dvb_diseqc_master_cmd &Command) = 0;
+  virtual bool SetParameters(dvb_frontend_parameters &Parameters) = 0;
+  virtual bool GetStatus(fe_status_t &Status) = 0;
+  virtual bool WaitForEvent(int TimeoutMs) = 0;
+         ///< Waits until the frontend reports an event (like getting or losing the
+         ///< lock), Wakeup() is called or TimeoutMs has expired. A TimeoutMs of -1
+         ///< waits without a timeout. Returns true if there was an event.
+  virtual void Wakeup(void) = 0;
+         ///< Makes a call to WaitForEvent() (or the next one) return immediately.
+  };
+
+/// The cDvbFrontendDevice accesses a frontend through the Linux DVB driver API.
+
+class cDvbFrontendDevice : public cDvbFrontend {
+private:
+  int fd_frontend;
+  int wakeupPipe[2];
+public:
+  cDvbFrontendDevice(int Fd_Frontend);
+         ///< Uses the already opened (non-blocking) frontend device Fd_Frontend.
+  virtual ~cDvbFrontendDevice();
+  virtual bool GetInfo(dvb_frontend_info &Info);
+  virtual bool SetVoltage(fe_sec_voltage_t Voltage);
+  virtual bool SetTone(fe_sec_tone_mode_t Tone);
+  virtual bool SendBurst(fe_sec_mini_cmd_t Burst);
+  virtual bool SendDiseqc(dvb_diseqc_master_cmd &Command);
+  virtual bool SetParameters(dvb_frontend_parameters &Parameters);
+  virtual bool GetStatus(fe_status_t &Status);
+  virtual bool WaitForEvent(int TimeoutMs);
+  virtual void Wakeup(void);
+  };
+
 /// The cDvbDevice implements a DVB device which can be accessed through the Linux DVB driver API.
 
 class cDvbDevice : public cDevice {
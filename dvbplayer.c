@@ -73,23 +73,90 @@ int cBackTrace::Get(bool Forward)
 
 // --- cNonBlockingFileReader ------------------------------------------------
 
+// The file reader keeps a window of the replay file in memory, which it fills
+// with large sequential reads up to the position the player has asked for.
+// Frames are then copied out of this window without waiting for the disk.
+// In trick modes the player hands over the I-frames it will display next,
+// which are then read in the order of their file offsets and kept for a while,
+// so that they can be used again if the direction is reversed.
+
+#define PREFETCHBUFSIZE MEGABYTE(8)   // the size of the read ahead window
+#define PREFETCHCHUNK   KILOBYTE(256) // the amount of data read in one go
+#define PREFETCHFRAMES  (3 * MAXPREFETCHIFRAMES) // the maximum number of I-frames kept in memory
+
+class cPrefetchFrame : public cListObject {
+public:
+  off_t offset;
+  int length;
+  int count; // -1 = not yet read
+  bool wanted;
+  uchar *data;
+  cPrefetchFrame(off_t Offset, int Length);
+  ~cPrefetchFrame();
+  };
+
+cPrefetchFrame::cPrefetchFrame(off_t Offset, int Length)
+{
+  offset = Offset;
+  length = Length;
+  count = -1;
+  wanted = true;
+  data = MALLOC(uchar, length);
+}
+
+cPrefetchFrame::~cPrefetchFrame()
+{
+  free(data);
+}
+
 class cNonBlockingFileReader : public cThread {
 private:
   cUnbufferedFile *f;
+  cUnbufferedFile *framesFile;
+  cList<cPrefetchFrame> frames;
+  cPrefetchFrame *pendingFrame;
+  cPrefetchFrame *loading;
+  uchar *data;
+  off_t offset;
+  int fill;
+  off_t ahead;
+  off_t consumed;
+  off_t next;
+  bool eof;
+  int error;
+  int generation;
   uchar *buffer;
   int wanted;
-  int length;
-  bool hasData;
   cCondWait newSet;
   cCondVar newDataCond;
-  cMutex newDataMutex;
+  cMutex dataMutex;
+  bool Ready(void);
+  cPrefetchFrame *GetFrame(cUnbufferedFile *File, off_t Offset, int Length);
+  int LoadFrame(cUnbufferedFile *File, cPrefetchFrame *Frame);
 protected:
   void Action(void);
 public:
   cNonBlockingFileReader(void);
   ~cNonBlockingFileReader();
-  void Clear(void);
-  int Read(cUnbufferedFile *File, uchar *Buffer, int Length);
+  void Clear(bool Flush = true);
+       ///< Discards all data that has been read so far, as well as any pending
+       ///< request. The file reader no longer accesses the file it has been
+       ///< reading from after this call. If Flush is false, the I-frames given
+       ///< to Prefetch() that have already been read are kept, as long as the
+       ///< file is not changed.
+  void Prefetch(cUnbufferedFile *File, int Count, const int *Offsets, const int *Lengths);
+       ///< Reads the Count frames at the given Offsets in File in advance, so that
+       ///< a later call to Read() for one of them returns immediately. Frames
+       ///< from earlier calls that are not in this list may be dropped.
+  int Read(cUnbufferedFile *File, off_t Offset, uchar *Buffer, int Length, off_t Ahead = -1);
+       ///< Reads Length bytes, starting at Offset in File, into Buffer. If Offset
+       ///< is negative, reading continues where the previous call left off.
+       ///< Ahead is the position in File up to which data shall be read in
+       ///< advance (-1 to read as far as the buffer allows).
+       ///< Returns the number of bytes copied into Buffer (which is only less
+       ///< than Length at the end of the file), or -1 with errno set to EAGAIN
+       ///< if the data is not yet available. In that case the function has to be
+       ///< called again with the same Buffer until it returns the data.
   bool Reading(void) { return buffer; }
   bool WaitForDataMs(int msToWait);
   };
@@ -98,10 +165,21 @@ cNonBlockingFileReader::cNonBlockingFileReader(void)
 :cThread("non blocking file reader")
 {
   f = NULL;
+  framesFile = NULL;
+  pendingFrame = NULL;
+  loading = NULL;
+  data = MALLOC(uchar, PREFETCHBUFSIZE);
+  offset = ahead = consumed = next = 0;
+  fill = 0;
+  eof = false;
+  error = 0;
+  generation = 0;
   buffer = NULL;
-  wanted = length = 0;
-  hasData = false;
-  Start();
+  wanted = 0;
+  if (data)
+     Start();
+  else
+     esyslog("ERROR: can't allocate file reader buffer");
 }
 
 cNonBlockingFileReader::~cNonBlockingFileReader()
@@ -109,37 +187,166 @@ cNonBlockingFileReader::~cNonBlockingFileReader()
   newSet.Signal();
   Cancel(3);
   free(buffer);
+  free(data);
 }
 
-void cNonBlockingFileReader::Clear(void)
+void cNonBlockingFileReader::Clear(bool Flush)
 {
-  Lock();
+  Lock(); // waits until a frame that is currently being loaded has been read
+  dataMutex.Lock();
   f = NULL;
+  if (Flush) {
+     frames.Clear();
+     framesFile = NULL;
+     }
+  else {
+     // The frames that have not been read yet are dropped, so that the file
+     // isn't accessed until the next call to Prefetch():
+     for (cPrefetchFrame *pf = frames.First(); pf; ) {
+         cPrefetchFrame *next = frames.Next(pf);
+         if (pf->count < 0)
+            frames.Del(pf);
+         pf = next;
+         }
+     }
+  pendingFrame = NULL;
   free(buffer);
   buffer = NULL;
-  wanted = length = 0;
-  hasData = false;
+  wanted = 0;
+  fill = 0;
+  eof = false;
+  error = 0;
+  generation++;
+  dataMutex.Unlock();
   Unlock();
   newSet.Signal();
 }
 
-int cNonBlockingFileReader::Read(cUnbufferedFile *File, uchar *Buffer, int Length)
+bool cNonBlockingFileReader::Ready(void)
+{
+  if (pendingFrame)
+     return error || pendingFrame->count >= 0;
+  return eof || error || offset + fill >= consumed + wanted;
+}
+
+cPrefetchFrame *cNonBlockingFileReader::GetFrame(cUnbufferedFile *File, off_t Offset, int Length)
+{
+  if (File == framesFile) {
+     for (cPrefetchFrame *pf = frames.First(); pf; pf = frames.Next(pf)) {
+         if (pf->offset == Offset && pf->length == Length)
+            return pf;
+         }
+     }
+  return NULL;
+}
+
+void cNonBlockingFileReader::Prefetch(cUnbufferedFile *File, int Count, const int *Offsets, const int *Lengths)
+{
+  cMutexLock DataLock(&dataMutex);
+  if (File != framesFile) {
+     if (loading)
+        return; // the old file is still being read from
+     frames.Clear();
+     framesFile = File;
+     }
+  for (cPrefetchFrame *pf = frames.First(); pf; pf = frames.Next(pf))
+      pf->wanted = false;
+  for (int i = 0; i < Count; i++) {
+      cPrefetchFrame *pf = GetFrame(File, Offsets[i], Lengths[i]);
+      if (pf)
+         pf->wanted = true;
+      else
+         frames.Add(new cPrefetchFrame(Offsets[i], Lengths[i]));
+      }
+  // drop the frames that have been used least recently and are no longer wanted:
+  for (cPrefetchFrame *pf = frames.First(); pf && frames.Count() > PREFETCHFRAMES; ) {
+      cPrefetchFrame *next = frames.Next(pf);
+      if (!pf->wanted && pf != loading && pf != pendingFrame)
+         frames.Del(pf);
+      pf = next;
+      }
+  newSet.Signal();
+}
+
+int cNonBlockingFileReader::LoadFrame(cUnbufferedFile *File, cPrefetchFrame *Frame)
+{
+  if (!Frame->data)
+     return 0;
+  if (File->Seek(Frame->offset, SEEK_SET) != Frame->offset)
+     return -1;
+  int n = 0;
+  while (n < Frame->length) {
+        int r = File->Read(Frame->data + n, Frame->length - n);
+        if (r < 0)
+           return r;
+        if (r == 0)
+           break; // EOF
+        n += r;
+        }
+  return n;
+}
+
+int cNonBlockingFileReader::Read(cUnbufferedFile *File, off_t Offset, uchar *Buffer, int Length, off_t Ahead)
 {
-  if (hasData && buffer) {
-     if (buffer != Buffer) {
-        esyslog("ERROR: cNonBlockingFileReader::Read() called with different buffer!");
-        errno = EINVAL;
-        return -1;
+  cMutexLock DataLock(&dataMutex);
+  if (buffer && buffer != Buffer) {
+     esyslog("ERROR: cNonBlockingFileReader::Read() called with different buffer!");
+     errno = EINVAL;
+     return -1;
+     }
+  if (!data) {
+     errno = ENOMEM;
+     return -1;
+     }
+  if (error) {
+     errno = error;
+     error = 0;
+     buffer = NULL;
+     return -1;
+     }
+  if (cPrefetchFrame *pf = (Offset >= 0) ? GetFrame(File, Offset, Length) : NULL) {
+     if (pf->count >= 0) {
+        memcpy(Buffer, pf->data, pf->count);
+        frames.Del(pf, false); // keeps the most recently used frames at the end of the list
+        frames.Add(pf);
+        pendingFrame = NULL;
+        buffer = NULL;
+        next = Offset + pf->count;
+        return pf->count;
+        }
+     if (!buffer) {
+        buffer = Buffer;
+        pendingFrame = pf;
+        newSet.Signal();
         }
+     errno = EAGAIN;
+     return -1;
+     }
+  pendingFrame = NULL;
+  if (Offset < 0)
+     Offset = File == f ? next : File->Seek(0, SEEK_CUR);
+  if (File != f || Offset < offset || Offset > offset + fill) {
+     // the requested data is outside the current window, so start a new one:
+     f = File;
+     offset = Offset;
+     fill = 0;
+     eof = false;
+     generation++;
+     }
+  consumed = Offset;
+  wanted = Length;
+  ahead = Ahead >= 0 ? max(Ahead, Offset + Length) : -1;
+  if (Ready()) {
+     int n = max(0, min(int(offset + fill - Offset), Length));
+     memcpy(Buffer, data + (Offset - offset), n);
+     next = consumed = Offset + n;
      buffer = NULL;
-     return length;
+     wanted = 0;
+     newSet.Signal(); // keeps reading ahead
+     return n;
      }
   if (!buffer) {
-     f = File;
      buffer = Buffer;
-     wanted = Length;
-     length = 0;
-     hasData = false;
      newSet.Signal();
      }
   errno = EAGAIN;
@@ -149,34 +356,109 @@ int cNonBlockingFileReader::Read(cUnbufferedFile *File, uchar *Buffer, int Lengt
 void cNonBlockingFileReader::Action(void)
 {
   while (Running()) {
+        bool Busy = false;
         Lock();
-        if (!hasData && f && buffer) {
-           int r = f->Read(buffer + length, wanted - length);
-           if (r >= 0) {
-              length += r;
-              if (!r || length == wanted) { // r == 0 means EOF
-                 cMutexLock NewDataLock(&newDataMutex);
-                 hasData = true;
+        dataMutex.Lock();
+        cPrefetchFrame *Load = NULL;
+        if (pendingFrame && pendingFrame->count < 0)
+           Load = pendingFrame;
+        else if (f && !eof && !error) {
+           // drop the data that has already been delivered:
+           int d = min(int(consumed - offset), fill);
+           if (d > 0 && (d >= PREFETCHBUFSIZE / 2 || fill == PREFETCHBUFSIZE)) {
+              memmove(data, data + d, fill - d);
+              offset += d;
+              fill -= d;
+              }
+           off_t End = offset + PREFETCHBUFSIZE;
+           if (ahead >= 0)
+              End = min(End, ahead);
+           if (offset + fill < End) {
+              cUnbufferedFile *File = f;
+              off_t Pos = offset + fill;
+              uchar *p = data + fill;
+              int n = min(int(End - Pos), PREFETCHCHUNK);
+              int Generation = generation;
+              dataMutex.Unlock();
+              // the consumer never touches the part of the buffer we are reading into:
+              int r = File->Seek(Pos, SEEK_SET) == Pos ? File->Read(p, n) : -1;
+              int e = errno;
+              dataMutex.Lock();
+              if (Generation == generation) {
+                 if (r > 0)
+                    fill += r;
+                 else if (r == 0)
+                    eof = true;
+                 else if (e && e != EAGAIN && e != EINTR) {
+                    errno = e;
+                    LOG_ERROR;
+                    error = e; // this will forward the error status to the caller
+                    }
                  newDataCond.Broadcast();
                  }
+              Busy = true;
               }
-           else if (r < 0 && FATALERRNO) {
+           }
+        if (!Load && !Busy && !error) {
+           // read the prefetched I-frames in the order of their offsets:
+           for (cPrefetchFrame *pf = frames.First(); pf; pf = frames.Next(pf)) {
+               if (pf->count < 0 && (!Load || pf->offset < Load->offset))
+                  Load = pf;
+               }
+           }
+        if (Load) {
+           cUnbufferedFile *File = framesFile;
+           loading = Load;
+           dataMutex.Unlock();
+           int r = LoadFrame(File, Load);
+           int e = errno;
+           dataMutex.Lock();
+           loading = NULL;
+           if (r >= 0)
+              Load->count = r;
+           else if (e && e != EAGAIN && e != EINTR) {
+              errno = e;
               LOG_ERROR;
-              length = r; // this will forward the error status to the caller
-              hasData = true;
+              Load->count = 0;
+              error = e; // this will forward the error status to the caller
               }
+           newDataCond.Broadcast();
+           Busy = true;
            }
+        dataMutex.Unlock();
         Unlock();
-        newSet.Wait(1000);
+        if (!Busy)
+           newSet.Wait(1000);
         }
 }
 
 bool cNonBlockingFileReader::WaitForDataMs(int msToWait)
 {
-  cMutexLock NewDataLock(&newDataMutex);
-  if (hasData)
+  cMutexLock DataLock(&dataMutex);
+  if (!buffer || Ready())
      return true;
-  return newDataCond.TimedWait(newDataMutex, msToWait);
+  return newDataCond.TimedWait(dataMutex, msToWait);
+}
+
+// --- Replay statistics -----------------------------------------------------
+
+// The time from a user's request (like a jump) to the first frame that is
+// handed to the device, as well as the time spent in the individual steps.
+
+enum eSeekOperation { soNone = -1, soGoto, soSkip, soResume, soTrickSpeed, soCount };
+enum eSeekPhase { spIndex, spFile, spRead, spCount };
+
+static const char *SeekOperationNames[soCount] = { "goto", "skip", "resume", "trick speed" };
+static const char *SeekPhaseNames[spCount] = { "index lookup", "file switch", "read" };
+
+static cMutex ReplayStatisticsMutex;
+static cHistogram SeekOperations[soCount];
+static cHistogram SeekPhases[spCount];
+
+static void AddSeekTime(cHistogram *Histogram, uint64_t Ms)
+{
+  cMutexLock MutexLock(&ReplayStatisticsMutex);
+  Histogram->Add(int(Ms));
 }
 
 // --- cDvbPlayer ------------------------------------------------------------
@@ -205,9 +487,16 @@ private:
   int readIndex, writeIndex;
   cFrame *readFrame;
   cFrame *playFrame;
+  cTimeMs seekTime;
+  int seekOperation;
+  bool seekRead;
+  void StartSeek(int Operation);
   void TrickSpeed(int Increment);
   void Empty(void);
   bool NextFile(uchar FileNumber = 0, int FileOffset = -1);
+  bool SelectFile(uchar FileNumber);
+  off_t PrefetchLimit(uchar FileNumber, int FileOffset);
+  void PrefetchIFrames(int Index, uchar FileNumber, int FileOffset, int Length, bool TimeShiftMode);
   int Resume(void);
   bool Save(void);
 protected:
@@ -249,6 +538,8 @@ cDvbPlayer::cDvbPlayer(const char *FileName)
   readIndex = writeIndex = -1;
   readFrame = NULL;
   playFrame = NULL;
+  seekOperation = soNone;
+  seekRead = false;
   isyslog("replay %s", FileName);
   fileName = new cFileName(FileName, false);
   replayFile = fileName->Open();
@@ -277,8 +568,17 @@ cDvbPlayer::~cDvbPlayer()
   delete ringBuffer;
 }
 
+void cDvbPlayer::StartSeek(int Operation)
+{
+  LOCK_THREAD;
+  seekTime.Set();
+  seekOperation = Operation;
+  seekRead = false;
+}
+
 void cDvbPlayer::TrickSpeed(int Increment)
 {
+  StartSeek(soTrickSpeed);
   int nts = trickSpeed + Increment;
   if (Speeds[nts] == 1) {
      trickSpeed = nts;
@@ -301,7 +601,7 @@ void cDvbPlayer::Empty(void)
 {
   LOCK_THREAD;
   if (nonBlockingFileReader)
-     nonBlockingFileReader->Clear();
+     nonBlockingFileReader->Clear(false); // keeps the I-frames for reversing the direction
   if ((readIndex = backTrace->Get(playDir == pdForward)) < 0)
      readIndex = writeIndex;
   delete readFrame; // might not have been stored in the buffer in Action()
@@ -341,22 +641,90 @@ static void StripExtendedPackets(uchar *b, int Length)
 
 bool cDvbPlayer::NextFile(uchar FileNumber, int FileOffset)
 {
-  if (FileNumber > 0)
+  if (FileNumber > 0) {
+     cTimeMs t;
+     bool Switch = FileNumber != fileName->Number();
+     if (nonBlockingFileReader && Switch)
+        nonBlockingFileReader->Clear(); // the file reader must not access the file that is closed now
      replayFile = fileName->SetOffset(FileNumber, FileOffset);
-  else if (replayFile && eof)
+     if (Switch && seekOperation != soNone)
+        AddSeekTime(&SeekPhases[spFile], t.Elapsed());
+     }
+  else if (replayFile && eof) {
+     if (nonBlockingFileReader)
+        nonBlockingFileReader->Clear(); // the file reader must not access the file that is closed now
      replayFile = fileName->NextFile();
+     }
+  eof = false;
+  return replayFile != NULL;
+}
+
+bool cDvbPlayer::SelectFile(uchar FileNumber)
+{
+  // The file reader positions the file itself, so we only switch files here:
+  if (replayFile && FileNumber == fileName->Number())
+     return true;
+  cTimeMs t;
+  nonBlockingFileReader->Clear(); // the file reader must not access the file that is closed now
+  replayFile = fileName->SetOffset(FileNumber, -1);
+  if (seekOperation != soNone)
+     AddSeekTime(&SeekPhases[spFile], t.Elapsed());
   eof = false;
   return replayFile != NULL;
 }
 
+off_t cDvbPlayer::PrefetchLimit(uchar FileNumber, int FileOffset)
+{
+  // Determines how far the file reader shall read ahead of the frame at readIndex.
+  // Only frames that are already in the index are taken into account, so that
+  // we never wait for a recording that is still going on.
+  int Frames = min(Setup.ReplayPrefetch, MAXPREFETCHFRAMES);
+  if (Frames > 0) {
+     int Index = min(readIndex + Frames, index->Last() - 1);
+     uchar Number;
+     int Offset;
+     if (Index > readIndex && index->Get(Index, &Number, &Offset))
+        return Number == FileNumber ? Offset : -1; // -1 = up to the end of this file
+     }
+  return FileOffset;
+}
+
+void cDvbPlayer::PrefetchIFrames(int Index, uchar FileNumber, int FileOffset, int Length, bool TimeShiftMode)
+{
+  // Hands the I-frames that will be displayed next in the current direction to
+  // the file reader. The faster we go, the more of them are read in advance.
+  int Frames = Setup.ReplayPrefetch > 0 ? min(abs(Speeds[trickSpeed]) + 2, MAXPREFETCHIFRAMES) : 1;
+  int Offsets[MAXPREFETCHIFRAMES];
+  int Lengths[MAXPREFETCHIFRAMES];
+  int n = 0;
+  if (0 < Length && Length <= MAXFRAMESIZE) {
+     Offsets[n] = FileOffset;
+     Lengths[n++] = Length;
+     }
+  while (n < Frames) {
+        uchar Number;
+        int Offset, l;
+        Index = index->GetNextIFrame(Index, playDir == pdForward, &Number, &Offset, &l, TimeShiftMode);
+        if (Index < 0 || Number != FileNumber || l <= 0 || l > MAXFRAMESIZE)
+           break;
+        Offsets[n] = Offset;
+        Lengths[n++] = l;
+        }
+  nonBlockingFileReader->Prefetch(replayFile, n, Offsets, Lengths);
+}
+
 int cDvbPlayer::Resume(void)
 {
   if (index) {
      int Index = index->GetResume();
      if (Index >= 0) {
+        StartSeek(soResume);
         uchar FileNumber;
         int FileOffset;
-        if (index->Get(Index, &FileNumber, &FileOffset) && NextFile(FileNumber, FileOffset))
+        cTimeMs t;
+        bool Ok = index->Get(Index, &FileNumber, &FileOffset);
+        AddSeekTime(&SeekPhases[spIndex], t.Elapsed());
+        if (Ok && NextFile(FileNumber, FileOffset))
            return Index;
         }
      }
@@ -402,6 +770,8 @@ void cDvbPlayer::Action(void)
 
   nonBlockingFileReader = new cNonBlockingFileReader;
   int Length = 0;
+  off_t ReadOffset = -1;
+  off_t ReadAhead = -1;
   bool Sleep = false;
   bool WaitingForData = false;
 
@@ -423,22 +793,25 @@ void cDvbPlayer::Action(void)
            if (playMode != pmStill && playMode != pmPause) {
               if (!readFrame && (replayFile || readIndex >= 0)) {
                  if (!nonBlockingFileReader->Reading()) {
+                    uchar FileNumber;
+                    int FileOffset;
                     if (playMode == pmFast || (playMode == pmSlow && playDir == pdBackward)) {
-                       uchar FileNumber;
-                       int FileOffset;
                        bool TimeShiftMode = index->IsStillRecording();
                        int Index = -1;
-                       if (DeviceHasIBPTrickSpeed() && playDir == pdForward) {
+                       bool IFrames = !(DeviceHasIBPTrickSpeed() && playDir == pdForward);
+                       if (!IFrames) {
                           if (index->Get(readIndex + 1, &FileNumber, &FileOffset, NULL, &Length))
                              Index = readIndex + 1;
                           }
                        else
                           Index = index->GetNextIFrame(readIndex, playDir == pdForward, &FileNumber, &FileOffset, &Length, TimeShiftMode);
                        if (Index >= 0) {
-                          if (!NextFile(FileNumber, FileOffset)) {
+                          if (!SelectFile(FileNumber)) {
                              readIndex = Index;
                              continue;
                              }
+                          ReadOffset = FileOffset;
+                          ReadAhead = IFrames ? FileOffset : PrefetchLimit(FileNumber, FileOffset);
                           }
                        else {
                           if (!TimeShiftMode && playDir == pdForward) {
@@ -460,19 +833,23 @@ void cDvbPlayer::Action(void)
                           continue;
                           }
                        readIndex = Index;
+                       if (IFrames)
+                          PrefetchIFrames(Index, FileNumber, FileOffset, Length, TimeShiftMode);
                        }
                     else if (index) {
-                       uchar FileNumber;
-                       int FileOffset;
                        readIndex++;
-                       if (!(index->Get(readIndex, &FileNumber, &FileOffset, NULL, &Length) && NextFile(FileNumber, FileOffset))) {
+                       if (!(index->Get(readIndex, &FileNumber, &FileOffset, NULL, &Length) && SelectFile(FileNumber))) {
                           readIndex = -1;
                           eof = true;
                           continue;
                           }
+                       ReadOffset = FileOffset;
+                       ReadAhead = PrefetchLimit(FileNumber, FileOffset);
                        }
-                    else // allows replay even if the index file is missing
+                    else { // allows replay even if the index file is missing
                        Length = MAXFRAMESIZE;
+                       ReadOffset = ReadAhead = -1;
+                       }
                     if (Length == -1)
                        Length = MAXFRAMESIZE; // this means we read up to EOF (see cIndex)
                     else if (Length > MAXFRAMESIZE) {
@@ -481,8 +858,12 @@ void cDvbPlayer::Action(void)
                        }
                     b = MALLOC(uchar, Length);
                     }
-                 int r = nonBlockingFileReader->Read(replayFile, b, Length);
+                 int r = nonBlockingFileReader->Read(replayFile, ReadOffset, b, Length, ReadAhead);
                  if (r > 0) {
+                    if (seekOperation != soNone && !seekRead) {
+                       AddSeekTime(&SeekPhases[spRead], seekTime.Elapsed());
+                       seekRead = true;
+                       }
                     WaitingForData = false;
                     readFrame = new cFrame(b, -r, ftUnknown, readIndex); // hands over b to the ringBuffer
                     b = NULL;
@@ -533,6 +914,10 @@ void cDvbPlayer::Action(void)
                  StripExtendedPackets(p, pc);
                  int w = PlayPes(p, pc, playMode != pmPlay);
                  if (w > 0) {
+                    if (seekOperation != soNone) {
+                       AddSeekTime(&SeekOperations[seekOperation], seekTime.Elapsed());
+                       seekOperation = soNone;
+                       }
                     p += w;
                     pc -= w;
                     }
@@ -703,12 +1088,16 @@ void cDvbPlayer::SkipSeconds(int Seconds)
 {
   if (index && Seconds) {
      LOCK_THREAD;
+     StartSeek(soSkip);
      Empty();
      int Index = writeIndex;
      if (Index >= 0) {
         Index = max(Index + Seconds * FRAMESPERSEC, 0);
-        if (Index > 0)
+        if (Index > 0) {
+           cTimeMs t;
            Index = index->GetNextIFrame(Index, false, NULL, NULL, NULL, true);
+           AddSeekTime(&SeekPhases[spIndex], t.Elapsed());
+           }
         if (Index >= 0)
            readIndex = writeIndex = Index - 1; // Action() will first increment it!
         }
@@ -720,16 +1109,21 @@ void cDvbPlayer::Goto(int Index, bool Still)
 {
   if (index) {
      LOCK_THREAD;
+     StartSeek(soGoto);
      Empty();
      if (++Index <= 0)
         Index = 1; // not '0', to allow GetNextIFrame() below to work!
      uchar FileNumber;
      int FileOffset, Length;
+     cTimeMs t;
      Index = index->GetNextIFrame(Index, false, &FileNumber, &FileOffset, &Length);
+     AddSeekTime(&SeekPhases[spIndex], t.Elapsed());
      if (Index >= 0 && NextFile(FileNumber, FileOffset) && Still) {
         uchar b[MAXFRAMESIZE + 4 + 5 + 4];
         int r = ReadFrame(replayFile, b, Length, sizeof(b));
         if (r > 0) {
+           AddSeekTime(&SeekPhases[spRead], seekTime.Elapsed());
+           seekRead = true;
            if (playMode == pmPause)
               DevicePlay();
            // append sequence end code to get the image shown immediately with softdevices
@@ -756,6 +1150,8 @@ void cDvbPlayer::Goto(int Index, bool Still)
               b[r++] = 0xB7;
               }
            DeviceStillPicture(b, r);
+           AddSeekTime(&SeekOperations[seekOperation], seekTime.Elapsed());
+           seekOperation = soNone;
            }
         playMode = pmStill;
         }
@@ -873,3 +1269,23 @@ void cDvbPlayerControl::Goto(int Position, bool Still)
   if (player)
      player->Goto(Position, Still);
 }
+
+cString cDvbPlayerControl::Statistics(void)
+{
+  cMutexLock MutexLock(&ReplayStatisticsMutex);
+  cString s = "";
+  for (int i = 0; i < soCount; i++)
+      s = cString::sprintf("%s%s: %s\n", *s, SeekOperationNames[i], *SeekOperations[i].ToString());
+  for (int i = 0; i < spCount; i++)
+      s = cString::sprintf("%s%s: %s\n", *s, SeekPhaseNames[i], *SeekPhases[i].ToString());
+  return s;
+}
+
+void cDvbPlayerControl::ClearStatistics(void)
+{
+  cMutexLock MutexLock(&ReplayStatisticsMutex);
+  for (int i = 0; i < soCount; i++)
+      SeekOperations[i].Clear();
+  for (int i = 0; i < spCount; i++)
+      SeekPhases[i].Clear();
+}
@@ -13,6 +13,9 @@
 #include "player.h"
 #include "thread.h"
 
+#define MAXPREFETCHFRAMES  250 // the maximum number of frames the player reads ahead
+#define MAXPREFETCHIFRAMES  16 // the maximum number of I-frames read ahead in fast forward/rewind
+
 class cDvbPlayer;
 
 class cDvbPlayerControl : public cControl {
@@ -54,6 +57,13 @@ public:
   void Goto(int Index, bool Still = false);
        // Positions to the given index and displays that frame as a still picture
        // if Still is true.
+  static cString Statistics(void);
+       // Returns the time (in ms) it took from a jump, a change of the replay
+       // speed or resuming a replay session to the first frame being handed to
+       // the device, together with the time spent looking up the index, switching
+       // files and reading the frame. There is one line per histogram.
+  static void ClearStatistics(void);
+       // Resets the statistics returned by Statistics().
   };
 
 #endif //__DVBPLAYER_H
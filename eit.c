@@ -17,6 +17,12 @@
 #include "libsi/section.h"
 #include "libsi/descriptor.h"
 
+#define EITSERVICEGUARD 2000 // ms to wait for further services after the last new one
+
+#define EITBATCHSIZE      64 // schedule sections entered into the EPG under one write lock
+#define EITBATCHTIME    1000 // ms after which pending schedule sections are entered anyway
+#define MAXEITPENDING   1024 // pending sections kept while the write lock can't be obtained
+
 // --- cEIT ------------------------------------------------------------------
 
 class cEIT : public SI::EIT {
@@ -310,6 +316,69 @@ cTDT::cTDT(const u_char *Data)
      }
 }
 
+// --- cEitTables ------------------------------------------------------------
+
+cEitTables::cEitTables(u_short ServiceId)
+{
+  serviceId = ServiceId;
+  lastTableId = 0;
+  tablesSeen = 0;
+  memset(lastSection, 0, sizeof(lastSection));
+  memset(segmentLast, 0, sizeof(segmentLast));
+  memset(seen, 0, sizeof(seen));
+}
+
+bool cEitTables::Seen(u_char Tid, const u_char *Data) const
+{
+  int t = Tid & 0x0F;
+  int Section = Data[6];
+  return (tablesSeen & (1 << t)) && (seen[t][Section / 8] & (1 << (Section % 8)));
+}
+
+void cEitTables::Mark(u_char Tid, const u_char *Data)
+{
+  int t = Tid & 0x0F;
+  int Section = Data[6];
+  int Segment = Section / 8;
+  tablesSeen |= 1 << t;
+  lastSection[t] = Data[7];
+  segmentLast[t][Segment] = Data[12];
+  seen[t][Segment] |= 1 << (Section % 8);
+  lastTableId = Data[13];
+}
+
+bool cEitTables::Complete(void) const
+{
+  if (!tablesSeen)
+     return false;
+  for (int t = 0; t <= (lastTableId & 0x0F); t++) {
+      if (!(tablesSeen & (1 << t)))
+         return false;
+      for (int g = 0; g <= lastSection[t] / 8; g++) {
+          int Last = max(int(segmentLast[t][g]), g * 8) % 8;
+          int Mask = (1 << (Last + 1)) - 1;
+          if (!seen[t][g] || (seen[t][g] & Mask) != Mask)
+             return false;
+          }
+      }
+  return true;
+}
+
+// --- cEitSection -----------------------------------------------------------
+
+cEitSection::cEitSection(int Source, u_char Tid, const u_char *Data, int Length)
+{
+  source = Source;
+  tid = Tid;
+  data = MALLOC(u_char, Length);
+  memcpy(data, Data, Length);
+}
+
+cEitSection::~cEitSection()
+{
+  free(data);
+}
+
 // --- cEitFilter ------------------------------------------------------------
 
 cEitFilter::cEitFilter(void)
@@ -318,25 +387,104 @@ cEitFilter::cEitFilter(void)
   Set(0x12, 0x50, 0xF0);  // event info, actual TS, schedule(0x50)/schedule for future days(0x5X)
   Set(0x12, 0x60, 0xF0);  // event info, other  TS, schedule(0x60)/schedule for future days(0x6X)
   Set(0x14, 0x70);        // TDT
+  SkipRepeatedSections();
+}
+
+void cEitFilter::SetStatus(bool On)
+{
+  cMutexLock MutexLock(&mutex);
+  tables.Clear();
+  lastNewService.Set();
+  if (!On) {
+     cMutexLock MutexLock(&pendingMutex);
+     EnterPending(); // if this fails, Flush() will do it later
+     }
+  cFilter::SetStatus(On);
+}
+
+void cEitFilter::Track(u_char Tid, const u_char *Data, int Length)
+{
+  // Only the schedule tables of the 'actual' transport stream tell us whether
+  // we have seen everything the transponder we're tuned to has to offer:
+  if ((Tid & 0xF0) != 0x50 || Length < 18 || (Data[13] & 0xF0) != 0x50)
+     return;
+  u_short ServiceId = (Data[3] << 8) | Data[4];
+  cMutexLock MutexLock(&mutex);
+  cEitTables *et = tables.First();
+  while (et && et->ServiceId() != ServiceId)
+        et = tables.Next(et);
+  if (et && et->Seen(Tid, Data))
+     return;
+  if (!SI::CRC32::isValid((const char *)Data, Length))
+     return;
+  if (!et) {
+     tables.Add(et = new cEitTables(ServiceId));
+     lastNewService.Set();
+     }
+  et->Mark(Tid, Data);
+}
+
+bool cEitFilter::Complete(void)
+{
+  cMutexLock MutexLock(&mutex);
+  if (!tables.Count() || lastNewService.Elapsed() < EITSERVICEGUARD)
+     return false;
+  for (cEitTables *et = tables.First(); et; et = tables.Next(et)) {
+      if (!et->Complete())
+         return false;
+      }
+  return true;
+}
+
+bool cEitFilter::EnterPending(void)
+{
+  if (!pending.Count())
+     return true;
+  cSchedulesLock SchedulesLock(true, 10);
+  cSchedules *Schedules = (cSchedules *)cSchedules::Schedules(SchedulesLock);
+  if (Schedules) {
+     for (cEitSection *es = pending.First(); es; es = pending.Next(es))
+         cEIT EIT(Schedules, es->source, es->tid, es->data);
+     pending.Clear();
+     return true;
+     }
+  return false;
+}
+
+void cEitFilter::Flush(void)
+{
+  cMutexLock MutexLock(&pendingMutex);
+  if (pending.Count() && pendingSince.Elapsed() >= EITBATCHTIME)
+     EnterPending();
 }
 
 void cEitFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length)
 {
   switch (Pid) {
     case 0x12: {
-         cSchedulesLock SchedulesLock(true, 10);
-         cSchedules *Schedules = (cSchedules *)cSchedules::Schedules(SchedulesLock);
-         if (Schedules)
-            cEIT EIT(Schedules, Source(), Tid, Data);
-         else {
-            // If we don't get a write lock, let's at least get a read lock, so
-            // that we can set the running status and 'seen' timestamp (well, actually
-            // with a read lock we shouldn't be doing that, but it's only integers that
-            // get changed, so it should be ok)
-            cSchedulesLock SchedulesLock;
-            cSchedules *Schedules = (cSchedules *)cSchedules::Schedules(SchedulesLock);
-            if (Schedules)
-               cEIT EIT(Schedules, Source(), Tid, Data, true);
+         Track(Tid, Data, Length);
+         // Present/following information is entered right away (together with
+         // whatever is pending), schedule sections are collected and entered
+         // in batches, so that readers of the EPG are interrupted less often:
+         cMutexLock MutexLock(&pendingMutex);
+         if (pending.Count() < MAXEITPENDING)
+            pending.Add(new cEitSection(Source(), Tid, Data, Length));
+         else
+            Reject(); // we'll get it again with the next repetition
+         if (pending.Count() == 1)
+            pendingSince.Set();
+         if (Tid == 0x4E || Tid == 0x4F || pending.Count() >= EITBATCHSIZE || pendingSince.Elapsed() >= EITBATCHTIME) {
+            if (!EnterPending() && (Tid == 0x4E || Tid == 0x4F)) {
+               // If we don't get a write lock, let's at least get a read lock, so
+               // that we can set the running status and 'seen' timestamp (well, actually
+               // with a read lock we shouldn't be doing that, but it's only integers that
+               // get changed, so it should be ok). The section stays pending and will be
+               // entered completely once the write lock is available.
+               cSchedulesLock SchedulesLock;
+               cSchedules *Schedules = (cSchedules *)cSchedules::Schedules(SchedulesLock);
+               if (Schedules)
+                  cEIT EIT(Schedules, Source(), Tid, Data, true);
+               }
             }
          }
          break;
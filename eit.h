@@ -11,12 +11,65 @@
 #define __EIT_H
 
 #include "filter.h"
+#include "thread.h"
+#include "tools.h"
+
+class cEitTables : public cListObject {
+private:
+  u_short serviceId;
+  u_char lastTableId;
+  u_short tablesSeen;
+  u_char lastSection[16];
+  u_char segmentLast[16][32];
+  u_char seen[16][32];
+public:
+  cEitTables(u_short ServiceId);
+  u_short ServiceId(void) const { return serviceId; }
+  bool Seen(u_char Tid, const u_char *Data) const;
+       ///< Returns true if the section in Data has already been seen.
+  void Mark(u_char Tid, const u_char *Data);
+       ///< Marks the section in Data as seen.
+  bool Complete(void) const;
+       ///< Returns true if all sections of all schedule tables of this
+       ///< service have been seen.
+  };
+
+class cEitSection : public cListObject {
+public:
+  int source;
+  u_char tid;
+  u_char *data;
+  cEitSection(int Source, u_char Tid, const u_char *Data, int Length);
+  ~cEitSection();
+  };
 
 class cEitFilter : public cFilter {
+private:
+  cMutex mutex;
+  cList<cEitTables> tables;
+  cTimeMs lastNewService;
+  cMutex pendingMutex;
+  cList<cEitSection> pending;
+  cTimeMs pendingSince;
+  void Track(u_char Tid, const u_char *Data, int Length);
+  bool EnterPending(void);
+       ///< Enters all pending sections into the EPG. Returns false if the
+       ///< schedules couldn't be locked, in which case they stay pending.
 protected:
+  virtual void SetStatus(bool On);
   virtual void Process(u_short Pid, u_char Tid, const u_char *Data, int Length);
 public:
   cEitFilter(void);
+  bool Complete(void);
+       ///< Returns true if all sections of the EIT schedule tables of the
+       ///< 'actual' transport stream have been received since the filter
+       ///< was last switched on (i.e. since the last channel switch).
+  void Flush(void);
+       ///< Enters the pending schedule sections into the EPG if they have
+       ///< been waiting for too long. Normally this is done when the next
+       ///< section arrives, but there may be none (for instance if the device
+       ///< has been tuned to a transponder without EIT), so this function
+       ///< needs to be called periodically.
   };
 
 #endif //__EIT_H
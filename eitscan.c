@@ -11,6 +11,7 @@
 #include <stdlib.h>
 #include "channels.h"
 #include "dvbdevice.h"
+#include "epg.h"
 #include "skins.h"
 #include "transfer.h"
 
@@ -19,9 +20,13 @@
 class cScanData : public cListObject {
 private:
   cChannel channel;
+  bool hasSchedule;
+  time_t expires;
+  time_t modified;
 public:
   cScanData(const cChannel *Channel);
   virtual int Compare(const cListObject &ListObject) const;
+  void AddSchedule(const cSchedule *Schedule);
   int Source(void) const { return channel.Source(); }
   int Transponder(void) const { return channel.Transponder(); }
   const cChannel *GetChannel(void) const { return &channel; }
@@ -30,11 +35,31 @@ public:
 cScanData::cScanData(const cChannel *Channel)
 {
   channel = *Channel;
+  hasSchedule = false;
+  expires = modified = 0;
+}
+
+void cScanData::AddSchedule(const cSchedule *Schedule)
+{
+  if (Schedule) {
+     const cEvent *Event = Schedule->Events()->Last();
+     time_t Expires = Event ? Event->EndTime() : 0;
+     if (!hasSchedule || Expires < expires)
+        expires = Expires;
+     if (!hasSchedule || Schedule->Modified() < modified)
+        modified = Schedule->Modified();
+     hasSchedule = true;
+     }
 }
 
 int cScanData::Compare(const cListObject &ListObject) const
 {
   const cScanData *sd = (const cScanData *)&ListObject;
+  // Transponders with the least EPG data come first:
+  if (expires != sd->expires)
+     return expires < sd->expires ? -1 : 1;
+  if (modified != sd->modified)
+     return modified < sd->modified ? -1 : 1;
   int r = Source() - sd->Source();
   if (r == 0)
      r = Transponder() - sd->Transponder();
@@ -45,25 +70,30 @@ int cScanData::Compare(const cListObject &ListObject) const
 
 class cScanList : public cList<cScanData> {
 public:
-  void AddTransponders(cList<cChannel> *Channels);
-  void AddTransponder(const cChannel *Channel);
+  void AddTransponders(cList<cChannel> *Channels, const cSchedules *Schedules);
+  void AddTransponder(const cChannel *Channel, const cSchedules *Schedules);
   };
 
-void cScanList::AddTransponders(cList<cChannel> *Channels)
+void cScanList::AddTransponders(cList<cChannel> *Channels, const cSchedules *Schedules)
 {
   for (cChannel *ch = Channels->First(); ch; ch = Channels->Next(ch))
-      AddTransponder(ch);
+      AddTransponder(ch, Schedules);
   Sort();
 }
 
-void cScanList::AddTransponder(const cChannel *Channel)
+void cScanList::AddTransponder(const cChannel *Channel, const cSchedules *Schedules)
 {
   if (Channel->Source() && Channel->Transponder()) {
+     const cSchedule *Schedule = Schedules ? Schedules->GetSchedule(Channel) : NULL;
      for (cScanData *sd = First(); sd; sd = Next(sd)) {
-         if (sd->Source() == Channel->Source() && ISTRANSPONDER(sd->Transponder(), Channel->Transponder()))
+         if (sd->Source() == Channel->Source() && ISTRANSPONDER(sd->Transponder(), Channel->Transponder())) {
+            sd->AddSchedule(Schedule);
             return;
+            }
          }
-     Add(new cScanData(Channel));
+     cScanData *sd = new cScanData(Channel);
+     sd->AddSchedule(Schedule);
+     Add(sd);
      }
 }
 
@@ -94,6 +124,7 @@ cEITScanner::cEITScanner(void)
   lastScan = lastActivity = time(NULL);
   currentDevice = NULL;
   currentChannel = 0;
+  memset(scanStart, 0, sizeof(scanStart));
   scanList = NULL;
   transponderList = NULL;
 }
@@ -122,6 +153,7 @@ void cEITScanner::Activity(void)
      Channels.SwitchTo(currentChannel);
      currentChannel = 0;
      }
+  memset(scanStart, 0, sizeof(scanStart));
   lastActivity = time(NULL);
 }
 
@@ -129,21 +161,34 @@ void cEITScanner::Process(void)
 {
   if ((Setup.EPGScanTimeout || !lastActivity) && Channels.MaxNumber() > 1) { // !lastActivity means a scan was forced
      time_t now = time(NULL);
-     if (now - lastScan > ScanTimeout && now - lastActivity > ActivityTimeout) {
+     if (now - lastScan > (scanList ? 0 : int(ScanTimeout)) && now - lastActivity > ActivityTimeout) {
         if (Channels.Lock(false, 10)) {
            if (!scanList) {
+              cSchedulesLock SchedulesLock(false, 10);
+              const cSchedules *Schedules = cSchedules::Schedules(SchedulesLock);
               scanList = new cScanList;
-              scanList->AddTransponders(&Channels);
+              scanList->AddTransponders(&Channels, Schedules);
               if (transponderList) {
-                 scanList->AddTransponders(transponderList);
+                 scanList->AddTransponders(transponderList, Schedules);
                  delete transponderList;
                  transponderList = NULL;
                  }
               }
-           bool AnyDeviceSwitched = false;
+           bool AnyDeviceScanning = false;
            for (int i = 0; i < cDevice::NumDevices(); i++) {
                cDevice *Device = cDevice::GetDevice(i);
                if (Device) {
+                  int n = Device->CardIndex();
+                  if (scanStart[n]) {
+                     // A device is done with its transponder as soon as it has seen all of its
+                     // EIT data, or has been taken over for something else:
+                     if (Device->Receiving() || Device->EitComplete() || now - scanStart[n] > ScanTimeout)
+                        scanStart[n] = 0;
+                     else {
+                        AnyDeviceScanning = true;
+                        continue;
+                        }
+                     }
                   for (cScanData *ScanData = scanList->First(); ScanData; ScanData = scanList->Next(ScanData)) {
                       const cChannel *Channel = ScanData->GetChannel();
                       if (Channel) {
@@ -164,7 +209,8 @@ void cEITScanner::Process(void)
                                      Device->SwitchChannel(Channel, false);
                                      currentDevice = NULL;
                                      scanList->Del(ScanData);
-                                     AnyDeviceSwitched = true;
+                                     scanStart[n] = now;
+                                     AnyDeviceScanning = true;
                                      break;
                                      }
                                   }
@@ -174,7 +220,7 @@ void cEITScanner::Process(void)
                       }
                   }
                }
-           if (!scanList->Count() || !AnyDeviceSwitched) {
+           if (!AnyDeviceScanning) {
               delete scanList;
               scanList = NULL;
               if (lastActivity == 0) // this was a triggered scan
@@ -182,7 +228,7 @@ void cEITScanner::Process(void)
               }
            Channels.Unlock();
            }
-        lastScan = time(NULL);
+        lastScan = now;
         }
      }
 }
@@ -24,6 +24,7 @@ private:
          ScanTimeout = 20
        };
   time_t lastScan, lastActivity;
+  time_t scanStart[MAXDEVICES];
   cDevice *currentDevice;
   int currentChannel;
   cScanList *scanList;
@@ -33,6 +34,9 @@ public:
   ~cEITScanner();
   bool Active(void) { return currentChannel || lastActivity == 0; }
   bool UsesDevice(const cDevice *Device) { return currentDevice == Device; }
+  bool Scans(const cDevice *Device) { return scanStart[Device->CardIndex()] != 0; }
+       ///< Returns true if Device is currently tuned to a transponder in order
+       ///< to collect its EPG data.
   void AddTransponder(cChannel *Channel);
   void ForceScan(void);
   void Activity(void);
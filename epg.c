@@ -12,13 +12,178 @@
 
 #include "epg.h"
 #include <ctype.h>
+#include <fcntl.h>
 #include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
+#include <wctype.h>
 #include "libsi/si.h"
 #include "timers.h"
 
 #define RUNNINGSTATUSTIMEOUT 30 // seconds before the running status is considered unknown
 
+// --- cStringPool -----------------------------------------------------------
+
+// Titles, short texts, descriptions and component descriptions repeat a lot
+// in EPG data (series, reruns, languages), so each distinct string is stored
+// only once and shared by all the events that use it.
+
+class cStringPool {
+private:
+  struct tString {
+    tString *next;
+    unsigned int hash;
+    int refs;
+    char s[1];
+    };
+  cMutex mutex;
+  tString **buckets;
+  int numBuckets;
+  int count;
+  static unsigned int Hash(const char *s);
+  tString *Find(const char *s, unsigned int Hash);
+  void Release(tString *String, unsigned int Hash);
+  void Grow(void);
+public:
+  cStringPool(void);
+  char *Get(const char *s);
+       ///< Returns a shared copy of s, which must not be modified and has to be
+       ///< given back with Put().
+  void Put(char *s);
+       ///< Gives back a string obtained from Get(). Any other string is freed.
+  char *Assign(char *s, const char *New) { char *p = Get(New); Put(s); return p; }
+  char *Own(char *s);
+       ///< Returns a private copy of s (which may be modified) and gives s back.
+  char *Share(char *s);
+       ///< Takes the private string s and returns a shared copy of it.
+  };
+
+static cStringPool *StringPool(void)
+{
+  static cStringPool *Pool = new cStringPool; // never deleted, since static events may outlive it
+  return Pool;
+}
+
+cStringPool::cStringPool(void)
+{
+  numBuckets = 4096;
+  buckets = (tString **)calloc(numBuckets, sizeof(tString *));
+  count = 0;
+}
+
+unsigned int cStringPool::Hash(const char *s)
+{
+  unsigned int h = 2166136261U; // FNV-1a
+  while (*s)
+        h = (h ^ (uchar)*s++) * 16777619U;
+  return h;
+}
+
+cStringPool::tString *cStringPool::Find(const char *s, unsigned int Hash)
+{
+  for (tString *p = buckets[Hash % numBuckets]; p; p = p->next) {
+      if (p->hash == Hash && strcmp(p->s, s) == 0)
+         return p;
+      }
+  return NULL;
+}
+
+void cStringPool::Release(tString *String, unsigned int Hash)
+{
+  if (--String->refs == 0) {
+     for (tString **p = &buckets[Hash % numBuckets]; *p; p = &(*p)->next) {
+         if (*p == String) {
+            *p = String->next;
+            break;
+            }
+         }
+     free(String);
+     count--;
+     }
+}
+
+void cStringPool::Grow(void)
+{
+  int n = numBuckets * 2;
+  tString **b = (tString **)calloc(n, sizeof(tString *));
+  if (!b)
+     return;
+  for (int i = 0; i < numBuckets; i++) {
+      tString *p = buckets[i];
+      while (p) {
+            tString *next = p->next;
+            p->next = b[p->hash % n];
+            b[p->hash % n] = p;
+            p = next;
+            }
+      }
+  free(buckets);
+  buckets = b;
+  numBuckets = n;
+}
+
+char *cStringPool::Get(const char *s)
+{
+  if (!s)
+     return NULL;
+  cMutexLock MutexLock(&mutex);
+  unsigned int h = Hash(s);
+  tString *p = Find(s, h);
+  if (!p) {
+     int l = strlen(s);
+     if ((p = (tString *)malloc(sizeof(tString) + l)) == NULL) {
+        esyslog("ERROR: out of memory");
+        return NULL;
+        }
+     memcpy(p->s, s, l + 1);
+     p->hash = h;
+     p->refs = 0;
+     if (count >= numBuckets * 2)
+        Grow();
+     p->next = buckets[h % numBuckets];
+     buckets[h % numBuckets] = p;
+     count++;
+     }
+  p->refs++;
+  return p->s;
+}
+
+void cStringPool::Put(char *s)
+{
+  if (!s)
+     return;
+  cMutexLock MutexLock(&mutex);
+  unsigned int h = Hash(s);
+  tString *p = Find(s, h);
+  if (p && p->s == s)
+     Release(p, h);
+  else
+     free(s);
+}
+
+char *cStringPool::Own(char *s)
+{
+  if (!s)
+     return NULL;
+  cMutexLock MutexLock(&mutex);
+  unsigned int h = Hash(s);
+  tString *p = Find(s, h);
+  if (p && p->s == s) {
+     s = strdup(s);
+     Release(p, h);
+     }
+  return s;
+}
+
+char *cStringPool::Share(char *s)
+{
+  char *p = Get(s);
+  free(s);
+  return p;
+}
+
 // --- tComponent ------------------------------------------------------------
 
 cString tComponent::ToString(void)
@@ -36,6 +201,8 @@ bool tComponent::FromString(const char *s)
      free(description);
      description = NULL;
      }
+  else
+     description = StringPool()->Share(description);
   stream = Stream;
   type = Type;
   return n >= 3;
@@ -52,7 +219,7 @@ cComponents::cComponents(void)
 cComponents::~cComponents(void)
 {
   for (int i = 0; i < numComponents; i++)
-      free(components[i].description);
+      StringPool()->Put(components[i].description);
   free(components);
 }
 
@@ -82,7 +249,7 @@ void cComponents::SetComponent(int Index, uchar Stream, uchar Type, const char *
   char *q = strchr(p->language, ',');
   if (q)
      *q = 0; // strips rest of "normalized" language codes
-  p->description = strcpyrealloc(p->description, !isempty(Description) ? Description : NULL);
+  p->description = StringPool()->Assign(p->description, !isempty(Description) ? Description : NULL);
 }
 
 tComponent *cComponents::GetComponent(int Index, uchar Stream, uchar Type)
@@ -118,9 +285,9 @@ cEvent::cEvent(tEventID EventID)
 
 cEvent::~cEvent()
 {
-  free(title);
-  free(shortText);
-  free(description);
+  StringPool()->Put(title);
+  StringPool()->Put(shortText);
+  StringPool()->Put(description);
   delete components;
 }
 
@@ -165,17 +332,17 @@ void cEvent::SetRunningStatus(int RunningStatus, cChannel *Channel)
 
 void cEvent::SetTitle(const char *Title)
 {
-  title = strcpyrealloc(title, Title);
+  title = StringPool()->Assign(title, Title);
 }
 
 void cEvent::SetShortText(const char *ShortText)
 {
-  shortText = strcpyrealloc(shortText, ShortText);
+  shortText = StringPool()->Assign(shortText, ShortText);
 }
 
 void cEvent::SetDescription(const char *Description)
 {
-  description = strcpyrealloc(description, Description);
+  description = StringPool()->Assign(description, Description);
 }
 
 void cEvent::SetComponents(cComponents *Components)
@@ -264,9 +431,9 @@ void cEvent::Dump(FILE *f, const char *Prefix, bool InfoOnly) const
      if (!isempty(shortText))
         fprintf(f, "%sS %s\n", Prefix, shortText);
      if (!isempty(description)) {
-        strreplace(description, '\n', '|');
-        fprintf(f, "%sD %s\n", Prefix, description);
-        strreplace(description, '|', '\n');
+        char *d = strreplace(strdup(description), '\n', '|'); // the description may be shared with other events
+        fprintf(f, "%sD %s\n", Prefix, d);
+        free(d);
         }
      if (components) {
         for (int i = 0; i < components->NumComponents(); i++) {
@@ -437,6 +604,17 @@ void ReportEpgBugFixStats(bool Reset)
 
 void cEvent::FixEpgBugs(void)
 {
+  // The texts are modified in place, so each event needs its own copies here:
+  title = StringPool()->Own(title);
+  shortText = StringPool()->Own(shortText);
+  description = StringPool()->Own(description);
+  if (components) {
+     for (int i = 0; i < components->NumComponents(); i++) {
+         tComponent *p = components->Component(i);
+         p->description = StringPool()->Own(p->description);
+         }
+     }
+
   if (isempty(title)) {
      // we don't want any "(null)" titles
      title = strcpyrealloc(title, tr("No title"));
@@ -644,6 +822,244 @@ Final:
   strreplace(description, '\x86', ' ');
   strreplace(description, '\x87', ' ');
   XXX*/
+
+  title = StringPool()->Share(title);
+  shortText = StringPool()->Share(shortText);
+  description = StringPool()->Share(description);
+  if (components) {
+     for (int i = 0; i < components->NumComponents(); i++) {
+         tComponent *p = components->Component(i);
+         p->description = StringPool()->Share(p->description);
+         }
+     }
+}
+
+// --- cEpgIndex ------------------------------------------------------------
+
+// Finding events by the words in their texts would mean scanning all of them,
+// so each schedule gets an inverted index of its words when it is first
+// searched. Adding or removing events, or marking the schedule as modified
+// (which cEIT does whenever it has changed an event), drops the index, and
+// it is rebuilt with the next search.
+
+static cMutex EpgIndexMutex;
+
+static inline bool IsAsciiAlnum(uint c)
+{
+  return uint((c | 0x20) - 'a') < 26 || uint(c - '0') < 10;
+}
+
+static bool IsWordChar(uint c)
+{
+  return c < 0x80 ? IsAsciiAlnum(c) : iswalnum(c) || !iswspace(c) && !iswpunct(c);
+}
+
+static const char *EpgWord(const char *s, u_int64_t &Word)
+{
+  // Returns a pointer to the end of the next word in s and sets Word to a hash
+  // of its lowercase symbols, or returns NULL if there are no more words:
+  if (s) {
+     while (*s) {
+           if (uchar(*s) < 0x80) {
+              if (IsAsciiAlnum(*s))
+                 break;
+              s++;
+              }
+           else {
+              int l = Utf8CharLen(s);
+              if (IsWordChar(Utf8CharGet(s, l)))
+                 break;
+              s += l;
+              }
+           }
+     if (*s) {
+        Word = 14695981039346656037ULL; // FNV-1a
+        while (*s) {
+              uint c = uchar(*s);
+              int l = 1;
+              if (c < 0x80) {
+                 if (!IsAsciiAlnum(c))
+                    break;
+                 if (c >= 'A')
+                    c |= 0x20; // lowercase
+                 }
+              else {
+                 l = Utf8CharLen(s);
+                 c = Utf8CharGet(s, l);
+                 if (!IsWordChar(c))
+                    break;
+                 c = towlower(c);
+                 }
+              Word = (Word ^ c) * 1099511628211ULL;
+              s += l;
+              }
+        return s;
+        }
+     }
+  return NULL;
+}
+
+class cEpgIndex {
+private:
+  int numWords;
+  u_int64_t *words; // the distinct words, sorted
+  int *first;       // the events containing words[i] are events[first[i]]...events[first[i + 1] - 1]
+  int *events;      // indexes into the events sorted by start time
+public:
+  cEpgIndex(const cVector<cEvent *> &Events);
+  ~cEpgIndex();
+  int Find(u_int64_t Word, const int **Events) const;
+       ///< Sets Events to the (ascending) indexes of the events that contain Word
+       ///< and returns their number.
+  };
+
+struct tEpgWord {
+  u_int64_t word;
+  int first, last; // the word's chain of postings
+  int lastEvent;
+  };
+
+static int CompareEpgWords(const void *a, const void *b)
+{
+  u_int64_t w1 = ((const tEpgWord *)a)->word;
+  u_int64_t w2 = ((const tEpgWord *)b)->word;
+  return w1 < w2 ? -1 : w1 > w2 ? 1 : 0;
+}
+
+static int CompareInts(const void *a, const void *b)
+{
+  return *(const int *)a - *(const int *)b;
+}
+
+template<class T> static bool Grow(T *&Array, int &Allocated, int Needed)
+{
+  if (Needed > Allocated) {
+     int n = max(Needed, Allocated ? Allocated * 2 : 1024);
+     T *p = (T *)realloc(Array, n * sizeof(T));
+     if (!p) {
+        esyslog("ERROR: out of memory");
+        return false;
+        }
+     Array = p;
+     Allocated = n;
+     }
+  return true;
+}
+
+cEpgIndex::cEpgIndex(const cVector<cEvent *> &Events)
+{
+  numWords = 0;
+  words = NULL;
+  first = NULL;
+  events = NULL;
+  // The words are collected in a hash table, each with a chain of the events
+  // it occurs in (which are visited in ascending order):
+  tEpgWord *w = NULL;
+  int NumWords = 0, AllocatedWords = 0;
+  int *Slots = NULL; // indexes into w, plus one (0 means empty)
+  int NumSlots = 0;
+  int *PostingEvents = NULL, *PostingNext = NULL;
+  int NumPostings = 0, AllocatedEvents = 0, AllocatedNext = 0;
+  bool Ok = true;
+  u_int64_t Word;
+  for (int i = 0; i < Events.Size() && Ok; i++) {
+      const char *Texts[] = { Events[i]->Title(), Events[i]->ShortText(), Events[i]->Description() };
+      for (unsigned int t = 0; t < sizeof(Texts) / sizeof(Texts[0]) && Ok; t++) {
+          for (const char *s = Texts[t]; Ok && (s = EpgWord(s, Word)) != NULL; ) {
+              if (NumWords * 2 >= NumSlots) {
+                 int n = NumSlots ? NumSlots * 2 : 1024;
+                 int *p = (int *)calloc(n, sizeof(int));
+                 if (!p) {
+                    esyslog("ERROR: out of memory");
+                    Ok = false;
+                    break;
+                    }
+                 for (int j = 0; j < NumWords; j++) {
+                     int k = w[j].word & (n - 1);
+                     while (p[k])
+                           k = (k + 1) & (n - 1);
+                     p[k] = j + 1;
+                     }
+                 free(Slots);
+                 Slots = p;
+                 NumSlots = n;
+                 }
+              int k = Word & (NumSlots - 1);
+              while (Slots[k] && w[Slots[k] - 1].word != Word)
+                    k = (k + 1) & (NumSlots - 1);
+              if (!Slots[k]) {
+                 if (!(Ok = Grow(w, AllocatedWords, NumWords + 1)))
+                    break;
+                 w[NumWords].word = Word;
+                 w[NumWords].first = w[NumWords].last = -1;
+                 w[NumWords].lastEvent = -1;
+                 Slots[k] = ++NumWords;
+                 }
+              tEpgWord *p = &w[Slots[k] - 1];
+              if (p->lastEvent != i) {
+                 if (!(Ok = Grow(PostingEvents, AllocatedEvents, NumPostings + 1) && Grow(PostingNext, AllocatedNext, NumPostings + 1)))
+                    break;
+                 PostingEvents[NumPostings] = i;
+                 PostingNext[NumPostings] = -1;
+                 if (p->last >= 0)
+                    PostingNext[p->last] = NumPostings;
+                 else
+                    p->first = NumPostings;
+                 p->last = NumPostings++;
+                 p->lastEvent = i;
+                 }
+              }
+          }
+      }
+  if (Ok && NumWords) {
+     qsort(w, NumWords, sizeof(tEpgWord), CompareEpgWords);
+     words = MALLOC(u_int64_t, NumWords);
+     first = MALLOC(int, NumWords + 1);
+     events = MALLOC(int, NumPostings);
+     if (words && first && events) {
+        int n = 0;
+        for (numWords = 0; numWords < NumWords; numWords++) {
+            words[numWords] = w[numWords].word;
+            first[numWords] = n;
+            for (int p = w[numWords].first; p >= 0; p = PostingNext[p])
+                events[n++] = PostingEvents[p];
+            }
+        first[numWords] = n;
+        }
+     else {
+        esyslog("ERROR: out of memory");
+        numWords = 0;
+        }
+     }
+  free(w);
+  free(Slots);
+  free(PostingEvents);
+  free(PostingNext);
+}
+
+cEpgIndex::~cEpgIndex()
+{
+  free(words);
+  free(first);
+  free(events);
+}
+
+int cEpgIndex::Find(u_int64_t Word, const int **Events) const
+{
+  int lo = 0;
+  int hi = numWords;
+  while (lo < hi) {
+        int m = (lo + hi) / 2;
+        if (words[m] < Word)
+           lo = m + 1;
+        else
+           hi = m;
+        }
+  if (lo < numWords && words[lo] == Word) {
+     *Events = events + first[lo];
+     return first[lo + 1] - first[lo];
+     }
+  return 0;
 }
 
 // --- cSchedule -------------------------------------------------------------
@@ -654,6 +1070,26 @@ cSchedule::cSchedule(tChannelID ChannelID)
   hasRunning = false;
   modified = 0;
   presentSeen = 0;
+  cached = false;
+  index = NULL;
+}
+
+cSchedule::~cSchedule()
+{
+  delete index;
+}
+
+void cSchedule::SetModified(void)
+{
+  modified = time(NULL);
+  cached = false;
+  DropIndex();
+}
+
+void cSchedule::DropIndex(void)
+{
+  cMutexLock MutexLock(&EpgIndexMutex);
+  DELETENULL(index);
 }
 
 cEvent *cSchedule::AddEvent(cEvent *Event)
@@ -676,70 +1112,150 @@ void cSchedule::DelEvent(cEvent *Event)
 
 void cSchedule::HashEvent(cEvent *Event)
 {
-  eventsHashID.Add(Event, Event->EventID());
-  if (Event->StartTime() > 0) // 'StartTime < 0' is apparently used with NVOD channels
-     eventsHashStartTime.Add(Event, Event->StartTime());
+  // cEIT may change an event's id or start time while holding only a read lock,
+  // so this must not interfere with a concurrent Search():
+  cMutexLock MutexLock(&EpgIndexMutex);
+  DELETENULL(index);
+  eventsByID.Insert(Event, SearchID(Event->EventID(), true));
+  eventsByStartTime.Insert(Event, EventsUpTo(Event->StartTime()));
 }
 
 void cSchedule::UnhashEvent(cEvent *Event)
 {
-  eventsHashID.Del(Event, Event->EventID());
-  if (Event->StartTime() > 0) // 'StartTime < 0' is apparently used with NVOD channels
-     eventsHashStartTime.Del(Event, Event->StartTime());
+  cMutexLock MutexLock(&EpgIndexMutex); // see HashEvent()
+  DELETENULL(index);
+  for (int i = SearchID(Event->EventID(), false); i < eventsByID.Size() && eventsByID[i]->EventID() == Event->EventID(); i++) {
+      if (eventsByID[i] == Event) {
+         eventsByID.Remove(i);
+         break;
+         }
+      }
+  int i = IndexOf(Event);
+  if (i >= 0)
+     eventsByStartTime.Remove(i);
+}
+
+int cSchedule::SearchID(tEventID EventID, bool After) const
+{
+  int Lo = 0;
+  int Hi = eventsByID.Size();
+  while (Lo < Hi) {
+        int Mid = (Lo + Hi) / 2;
+        if (eventsByID[Mid]->EventID() < EventID || After && eventsByID[Mid]->EventID() == EventID)
+           Lo = Mid + 1;
+        else
+           Hi = Mid;
+        }
+  return Lo;
+}
+
+int cSchedule::EventsUpTo(time_t Time) const
+{
+  int Lo = 0;
+  int Hi = eventsByStartTime.Size();
+  while (Lo < Hi) {
+        int Mid = (Lo + Hi) / 2;
+        if (eventsByStartTime[Mid]->StartTime() <= Time)
+           Lo = Mid + 1;
+        else
+           Hi = Mid;
+        }
+  return Lo;
+}
+
+int cSchedule::IndexOf(const cEvent *Event) const
+{
+  for (int i = EventsUpTo(Event->StartTime() - 1); i < eventsByStartTime.Size() && eventsByStartTime[i]->StartTime() == Event->StartTime(); i++) {
+      if (eventsByStartTime[i] == Event)
+         return i;
+      }
+  return -1;
 }
 
 const cEvent *cSchedule::GetPresentEvent(void) const
 {
-  const cEvent *pe = NULL;
   time_t now = time(NULL);
-  for (cEvent *p = events.First(); p; p = events.Next(p)) {
-      if (p->StartTime() <= now)
-         pe = p;
-      else if (p->StartTime() > now + 3600)
-         break;
+  // An event that is signalled as running takes precedence (outdated events
+  // have been removed by Cleanup(), so there are only few to check here):
+  for (int i = 0, n = EventsUpTo(now + 3600); i < n; i++) {
+      const cEvent *p = eventsByStartTime[i];
       if (p->SeenWithin(RUNNINGSTATUSTIMEOUT) && p->RunningStatus() >= SI::RunningStatusPausing)
          return p;
       }
-  return pe;
+  int n = EventsUpTo(now);
+  return n > 0 ? eventsByStartTime[n - 1] : NULL;
 }
 
 const cEvent *cSchedule::GetFollowingEvent(void) const
 {
   const cEvent *p = GetPresentEvent();
-  if (p)
-     p = events.Next(p);
-  else {
-     time_t now = time(NULL);
-     for (p = events.First(); p; p = events.Next(p)) {
-         if (p->StartTime() >= now)
-            break;
-         }
-     }
-  return p;
+  int i = p ? IndexOf(p) + 1 : EventsUpTo(time(NULL) - 1);
+  return i < eventsByStartTime.Size() ? eventsByStartTime[i] : NULL;
 }
 
 const cEvent *cSchedule::GetEvent(tEventID EventID, time_t StartTime) const
 {
   // Returns the event info with the given StartTime or, if no actual StartTime
   // is given, the one with the given EventID.
-  if (StartTime > 0) // 'StartTime < 0' is apparently used with NVOD channels
-     return eventsHashStartTime.Get(StartTime);
-  else
-     return eventsHashID.Get(EventID);
+  if (StartTime > 0) { // 'StartTime < 0' is apparently used with NVOD channels
+     int i = EventsUpTo(StartTime - 1);
+     return i < eventsByStartTime.Size() && eventsByStartTime[i]->StartTime() == StartTime ? eventsByStartTime[i] : NULL;
+     }
+  else {
+     int i = SearchID(EventID, false);
+     return i < eventsByID.Size() && eventsByID[i]->EventID() == EventID ? eventsByID[i] : NULL;
+     }
 }
 
 const cEvent *cSchedule::GetEventAround(time_t Time) const
 {
-  const cEvent *pe = NULL;
-  time_t delta = INT_MAX;
-  for (cEvent *p = events.First(); p; p = events.Next(p)) {
-      time_t dt = Time - p->StartTime();
-      if (dt >= 0 && dt < delta && p->EndTime() >= Time) {
-         delta = dt;
-         pe = p;
+  // The latest event that starts at or before Time and is still running at Time:
+  for (int i = EventsUpTo(Time) - 1; i >= 0; i--) {
+      const cEvent *p = eventsByStartTime[i];
+      if (p->EndTime() >= Time)
+         return p;
+      }
+  return NULL;
+}
+
+int cSchedule::Search(const cVector<u_int64_t> &Words, cVector<const cEvent *> &Events) const
+{
+  cMutexLock MutexLock(&EpgIndexMutex);
+  if (!index)
+     ((cSchedule *)this)->index = new cEpgIndex(eventsByStartTime);
+  // The events of the word with the fewest events are checked for the others:
+  const int *Matches[Words.Size()];
+  int NumMatches[Words.Size()];
+  int Shortest = 0;
+  for (int i = 0; i < Words.Size(); i++) {
+      if ((NumMatches[i] = index->Find(Words[i], &Matches[i])) == 0)
+         return 0;
+      if (NumMatches[i] < NumMatches[Shortest])
+         Shortest = i;
+      }
+  int Count = 0;
+  for (int m = 0; m < NumMatches[Shortest]; m++) {
+      int Event = Matches[Shortest][m];
+      bool Match = true;
+      for (int i = 0; i < Words.Size() && Match; i++) {
+          if (i != Shortest)
+             Match = bsearch(&Event, Matches[i], NumMatches[i], sizeof(int), CompareInts) != NULL;
+          }
+      if (Match) {
+         Events.Append(eventsByStartTime[Event]);
+         Count++;
          }
       }
-  return pe;
+  return Count;
+}
+
+int cSchedule::Search(const char *Query, cVector<const cEvent *> &Events) const
+{
+  cVector<u_int64_t> Words;
+  u_int64_t Word;
+  for (const char *s = Query; (s = EpgWord(s, Word)) != NULL; )
+      Words.Append(Word);
+  return Words.Size() ? Search(Words, Events) : 0;
 }
 
 void cSchedule::SetRunningStatus(cEvent *Event, int RunningStatus, cChannel *Channel)
@@ -823,15 +1339,63 @@ void cSchedule::Cleanup(void)
   Cleanup(time(NULL));
 }
 
-void cSchedule::Cleanup(time_t Time)
+static void DropNull(cVector<cEvent *> &Events)
 {
-  cEvent *Event;
-  while ((Event = events.First()) != NULL) {
-        if (!Event->HasTimer() && Event->EndTime() + Setup.EPGLinger * 60 + 3600 < Time) // adding one hour for safety
-           DelEvent(Event);
-        else
-           break;
-        }
+  int n = 0;
+  for (int i = 0; i < Events.Size(); i++) {
+      if (Events[i])
+         Events[n++] = Events[i];
+      }
+  while (Events.Size() > n)
+        Events.Remove(Events.Size() - 1);
+}
+
+void cSchedule::Cleanup(time_t Time, cList<cEvent> *Outdated)
+{
+  // The outdated events are at the start of the list. They are looked up in
+  // the indexes first and then removed from them in a single pass, instead of
+  // moving the rest of the indexes for each of them:
+  int n = 0;
+  for (cEvent *Event = events.First(); Event; Event = events.Next(Event)) {
+      if (Event->HasTimer() || Event->EndTime() + Setup.EPGLinger * 60 + 3600 >= Time) // adding one hour for safety
+         break;
+      if (hasRunning && Event->IsRunning())
+         ClrRunningStatus();
+      n++;
+      }
+  if (n) {
+     cVector<int> ByID(n), ByStartTime(n);
+     cEvent *Event = events.First();
+     for (int i = 0; i < n; i++) {
+         ByID[i] = -1;
+         for (int j = SearchID(Event->EventID(), false); j < eventsByID.Size() && eventsByID[j]->EventID() == Event->EventID(); j++) {
+             if (eventsByID[j] == Event) {
+                ByID[i] = j;
+                break;
+                }
+             }
+         ByStartTime[i] = IndexOf(Event);
+         Event = events.Next(Event);
+         }
+     for (int i = 0; i < n; i++) {
+         if (ByID[i] >= 0)
+            eventsByID[ByID[i]] = NULL;
+         if (ByStartTime[i] >= 0)
+            eventsByStartTime[ByStartTime[i]] = NULL;
+         }
+     DropNull(eventsByID);
+     DropNull(eventsByStartTime);
+     DropIndex();
+     while (n--) {
+           Event = events.First();
+           events.Del(Event, false);
+           Event->schedule = NULL;
+           if (Outdated)
+              Outdated->Add(Event);
+           else
+              delete Event;
+           }
+     }
 }
 
 void cSchedule::Dump(FILE *f, const char *Prefix, eDumpMode DumpMode, time_t AtTime) const
@@ -904,6 +1468,182 @@ bool cSchedule::Read(FILE *f, cSchedules *Schedules)
   return false;
 }
 
+// The EPG cache holds one file per schedule in a binary format that can be
+// loaded without any parsing. Numbers are stored in the host's byte order,
+// since the cache is only read by the VDR that has written it.
+
+#define EPGCACHEMAGIC   "VDREPGC"
+#define EPGCACHEVERSION 2
+#define EPGCACHEINDEX   "index"
+
+struct tEpgCacheHeader {
+  char magic[8];
+  u_int32_t version;
+  u_int32_t count; // number of events (0 in the index file)
+  tEpgCacheHeader(u_int32_t Count = 0) { memset(magic, 0, sizeof(magic)); strcpy(magic, EPGCACHEMAGIC); version = EPGCACHEVERSION; count = Count; }
+  bool Ok(void) const { return strcmp(magic, EPGCACHEMAGIC) == 0 && version == EPGCACHEVERSION; }
+  };
+
+class cEpgCacheReader {
+private:
+  const uchar *data;
+  int length;
+  int offset;
+  bool ok;
+public:
+  cEpgCacheReader(const uchar *Data, int Length) { data = Data; length = Length; offset = 0; ok = true; }
+  bool Ok(void) { return ok; }
+  void Get(void *Value, int Size);
+  const char *GetString(void);
+       ///< Returns a pointer to the string at the current position (which is
+       ///< only valid as long as the data is), or NULL if there is none.
+  };
+
+void cEpgCacheReader::Get(void *Value, int Size)
+{
+  if (ok && offset + Size <= length) {
+     memcpy(Value, data + offset, Size);
+     offset += Size;
+     }
+  else {
+     memset(Value, 0, Size);
+     ok = false;
+     }
+}
+
+const char *cEpgCacheReader::GetString(void)
+{
+  u_int32_t l;
+  Get(&l, sizeof(l));
+  if (ok && l) {
+     if (l <= u_int32_t(length - offset) && data[offset + l - 1] == 0) {
+        const char *s = (const char *)data + offset;
+        offset += l;
+        return s;
+        }
+     ok = false;
+     }
+  return NULL;
+}
+
+static void EpgCachePutString(FILE *f, const char *s)
+{
+  u_int32_t l = s ? strlen(s) + 1 : 0;
+  fwrite(&l, sizeof(l), 1, f);
+  if (l)
+     fwrite(s, l, 1, f);
+}
+
+bool cSchedule::Store(FILE *f) const
+{
+  time_t Outdated = time(NULL) - Setup.EPGLinger * 60;
+  u_int32_t Count = 0;
+  for (const cEvent *p = events.First(); p; p = events.Next(p)) {
+      if (p->EndTime() >= Outdated)
+         Count++;
+      }
+  tEpgCacheHeader Header(Count);
+  fwrite(&Header, sizeof(Header), 1, f);
+  EpgCachePutString(f, channelID.ToString());
+  for (const cEvent *p = events.First(); p; p = events.Next(p)) {
+      if (p->EndTime() >= Outdated) {
+         u_int32_t EventID = p->eventID;
+         int64_t StartTime = p->startTime;
+         int32_t Duration = p->duration;
+         int64_t Vps = p->vps;
+         fwrite(&EventID, sizeof(EventID), 1, f);
+         fwrite(&StartTime, sizeof(StartTime), 1, f);
+         fwrite(&Duration, sizeof(Duration), 1, f);
+         fwrite(&Vps, sizeof(Vps), 1, f);
+         fwrite(&p->tableID, sizeof(p->tableID), 1, f);
+         fwrite(&p->version, sizeof(p->version), 1, f);
+         EpgCachePutString(f, p->title);
+         EpgCachePutString(f, p->shortText);
+         EpgCachePutString(f, p->description);
+         u_int32_t NumComponents = p->components ? p->components->NumComponents() : 0;
+         fwrite(&NumComponents, sizeof(NumComponents), 1, f);
+         for (u_int32_t i = 0; i < NumComponents; i++) {
+             tComponent *c = p->components->Component(i);
+             fwrite(&c->stream, sizeof(c->stream), 1, f);
+             fwrite(&c->type, sizeof(c->type), 1, f);
+             fwrite(c->language, sizeof(c->language), 1, f);
+             EpgCachePutString(f, c->description);
+             }
+         }
+      }
+  return ferror(f) == 0;
+}
+
+bool cSchedule::Load(const uchar *Data, int Length, cSchedules *Schedules)
+{
+  cEpgCacheReader Reader(Data, Length);
+  tEpgCacheHeader Header;
+  Reader.Get(&Header, sizeof(Header));
+  const char *s = Reader.GetString();
+  if (!Reader.Ok() || !Header.Ok() || !s)
+     return false;
+  tChannelID ChannelID = tChannelID::FromString(s);
+  if (!ChannelID.Valid())
+     return false;
+  cSchedule *Schedule = Schedules->AddSchedule(ChannelID);
+  for (u_int32_t n = 0; n < Header.count; n++) {
+      u_int32_t EventID;
+      int64_t StartTime;
+      int32_t Duration;
+      int64_t Vps;
+      uchar TableID, Version;
+      Reader.Get(&EventID, sizeof(EventID));
+      Reader.Get(&StartTime, sizeof(StartTime));
+      Reader.Get(&Duration, sizeof(Duration));
+      Reader.Get(&Vps, sizeof(Vps));
+      Reader.Get(&TableID, sizeof(TableID));
+      Reader.Get(&Version, sizeof(Version));
+      const char *Title = Reader.GetString();
+      const char *ShortText = Reader.GetString();
+      const char *Description = Reader.GetString();
+      u_int32_t NumComponents;
+      Reader.Get(&NumComponents, sizeof(NumComponents));
+      cComponents *Components = NULL;
+      for (u_int32_t i = 0; i < NumComponents && Reader.Ok(); i++) {
+          uchar Stream, Type;
+          char Language[MAXLANGCODE2];
+          Reader.Get(&Stream, sizeof(Stream));
+          Reader.Get(&Type, sizeof(Type));
+          Reader.Get(Language, sizeof(Language));
+          Language[sizeof(Language) - 1] = 0;
+          const char *d = Reader.GetString();
+          if (!Components)
+             Components = new cComponents;
+          Components->SetComponent(i, Stream, Type, Language, d);
+          }
+      if (!Reader.Ok()) {
+         delete Components;
+         break;
+         }
+      cEvent *Event = (cEvent *)Schedule->GetEvent(EventID, StartTime);
+      cEvent *newEvent = NULL;
+      if (!Event) {
+         Event = newEvent = new cEvent(EventID);
+         Event->seen = 0;
+         }
+      Event->SetTableID(TableID);
+      Event->SetVersion(Version);
+      Event->SetStartTime(StartTime);
+      Event->SetDuration(Duration);
+      Event->SetTitle(Title ? Title : tr("No title"));
+      Event->SetShortText(ShortText);
+      Event->SetDescription(Description);
+      Event->SetComponents(Components);
+      Event->SetVps(Vps);
+      if (newEvent)
+         Schedule->AddEvent(newEvent);
+      }
+  Schedule->Sort();
+  Schedules->SetModified(Schedule);
+  Schedule->cached = Reader.Ok();
+  return Reader.Ok();
+}
+
 // --- cSchedulesLock --------------------------------------------------------
 
 cSchedulesLock::cSchedulesLock(bool WriteLock, int TimeoutMs)
@@ -951,24 +1691,33 @@ void cSchedules::Cleanup(bool Force)
   struct tm *ptm = localtime_r(&now, &tm_r);
   if (now - lastCleanup > 3600) {
      isyslog("cleaning up schedules data");
-     cSchedulesLock SchedulesLock(true, 1000);
-     cSchedules *s = (cSchedules *)Schedules(SchedulesLock);
-     if (s) {
-        for (cSchedule *p = s->First(); p; p = s->Next(p))
-            p->Cleanup(now);
-        }
+     cList<cEvent> Outdated;
+     {
+       cSchedulesLock SchedulesLock(true, 1000);
+       cSchedules *s = (cSchedules *)Schedules(SchedulesLock);
+       if (s) {
+          for (cSchedule *p = s->First(); p; p = s->Next(p))
+              p->Cleanup(now, &Outdated);
+          }
+     }
+     Outdated.Clear(); // after releasing the lock, since this takes most of the time
      lastCleanup = now;
      if (ptm->tm_hour == 5)
         ReportEpgBugFixStats(true);
      }
   if (epgDataFileName && now - lastDump > 600) {
-     cSafeFile f(epgDataFileName);
-     if (f.Open()) {
-        Dump(f);
-        f.Close();
+     if (Force) {
+        // While running, only the EPG cache is kept up to date, and the EPG data
+        // file is written when VDR exits:
+        cSafeFile f(epgDataFileName);
+        if (f.Open()) {
+           Dump(f);
+           f.Close();
+           }
+        else
+           LOG_ERROR;
         }
-     else
-        LOG_ERROR;
+     WriteCache(); // after the EPG data file, so that the cache is used at the next startup
      lastDump = now;
      }
 }
@@ -985,13 +1734,16 @@ void cSchedules::ResetVersions(void)
 
 bool cSchedules::ClearAll(void)
 {
+  cList<cEvent> Outdated; // deleted after releasing the lock
   cSchedulesLock SchedulesLock(true, 1000);
   cSchedules *s = (cSchedules *)Schedules(SchedulesLock);
   if (s) {
      for (cTimer *Timer = Timers.First(); Timer; Timer = Timers.Next(Timer))
          Timer->SetEvent(NULL);
-     for (cSchedule *Schedule = s->First(); Schedule; Schedule = s->Next(Schedule))
-         Schedule->Cleanup(INT_MAX);
+     for (cSchedule *Schedule = s->First(); Schedule; Schedule = s->Next(Schedule)) {
+         Schedule->Cleanup(INT_MAX, &Outdated);
+         s->SetModified(Schedule);
+         }
      return true;
      }
   return false;
@@ -999,14 +1751,185 @@ bool cSchedules::ClearAll(void)
 
 bool cSchedules::Dump(FILE *f, const char *Prefix, eDumpMode DumpMode, time_t AtTime)
 {
-  cSchedulesLock SchedulesLock;
-  cSchedules *s = (cSchedules *)Schedules(SchedulesLock);
-  if (s) {
-     for (cSchedule *p = s->First(); p; p = s->Next(p))
-         p->Dump(f, Prefix, DumpMode, AtTime);
-     return true;
+  // Each schedule is copied while holding the lock and written to f after
+  // releasing it, so that a slow disk or client doesn't hold up the EIT filters,
+  // which need the write lock, and only one schedule is held in memory at a time.
+  // Schedules are never deleted, so p stays valid while the lock is released.
+  const cSchedule *p = NULL;
+  for (;;) {
+      char *Buffer = NULL;
+      size_t Size = 0;
+      {
+        cSchedulesLock SchedulesLock;
+        const cSchedules *s = Schedules(SchedulesLock);
+        if (!s)
+           return false;
+        p = p ? s->Next(p) : s->First();
+        if (!p)
+           return true;
+        FILE *m = open_memstream(&Buffer, &Size);
+        if (!m) {
+           LOG_ERROR;
+           return false;
+           }
+        p->Dump(m, Prefix, DumpMode, AtTime);
+        fclose(m);
+      }
+      bool Written = fwrite(Buffer, 1, Size, f) == Size;
+      free(Buffer);
+      if (!Written)
+         return false;
+      }
+}
+
+cString cSchedules::CacheDirectory(void)
+{
+  return cString::sprintf("%s.cache", epgDataFileName);
+}
+
+class cEpgCacheFile : public cListObject {
+public:
+  tChannelID channelID;
+  char *buffer;
+  size_t size;
+  bool failed;
+  cEpgCacheFile(tChannelID ChannelID, char *Buffer, size_t Size) { channelID = ChannelID; buffer = Buffer; size = Size; failed = false; }
+  ~cEpgCacheFile() { free(buffer); }
+  };
+
+bool cSchedules::ReadCache(cSchedules *Schedules)
+{
+  if (!epgDataFileName)
+     return false;
+  cString Directory = CacheDirectory();
+  cString IndexFileName = AddDirectory(Directory, EPGCACHEINDEX);
+  struct stat Index, Data;
+  if (stat(IndexFileName, &Index) != 0)
+     return false;
+  if (stat(epgDataFileName, &Data) == 0 && Data.st_mtime > Index.st_mtime) {
+     isyslog("EPG cache is older than %s", epgDataFileName);
+     return false;
+     }
+  tEpgCacheHeader Header;
+  FILE *f = fopen(IndexFileName, "r");
+  if (!f) {
+     LOG_ERROR_STR(*IndexFileName);
+     return false;
+     }
+  bool Ok = fread(&Header, sizeof(Header), 1, f) == 1 && Header.Ok();
+  fclose(f);
+  if (!Ok) {
+     isyslog("ignoring EPG cache %s due to a different format", *Directory);
+     return false;
+     }
+  cReadDir d(Directory);
+  if (!d.Ok()) {
+     LOG_ERROR_STR(*Directory);
+     return false;
+     }
+  dsyslog("reading EPG cache from %s", *Directory);
+  struct dirent *e;
+  while ((e = d.Next()) != NULL) {
+        if (*e->d_name == '.' || strcmp(e->d_name, EPGCACHEINDEX) == 0 || endswith(e->d_name, ".$$$"))
+           continue;
+        cString FileName = AddDirectory(Directory, e->d_name);
+        int fd = open(FileName, O_RDONLY);
+        if (fd >= 0) {
+           struct stat st;
+           if (fstat(fd, &st) == 0 && st.st_size > 0) {
+              void *Data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+              if (Data != MAP_FAILED) {
+                 if (!cSchedule::Load((const uchar *)Data, st.st_size, Schedules))
+                    esyslog("ERROR: invalid EPG cache file %s", *FileName);
+                 munmap(Data, st.st_size);
+                 }
+              else
+                 LOG_ERROR_STR(*FileName);
+              }
+           close(fd);
+           }
+        else
+           LOG_ERROR_STR(*FileName);
+        }
+  return true;
+}
+
+void cSchedules::WriteCache(void)
+{
+  // The modified schedules are stored in memory while holding the lock and
+  // written to disk after releasing it:
+  cList<cEpgCacheFile> Files;
+  {
+    cSchedulesLock SchedulesLock;
+    cSchedules *s = (cSchedules *)Schedules(SchedulesLock);
+    if (!s)
+       return;
+    for (cSchedule *p = s->First(); p; p = s->Next(p)) {
+        if (!p->cached) {
+           char *Buffer = NULL;
+           size_t Size = 0;
+           FILE *f = open_memstream(&Buffer, &Size);
+           if (f) {
+              bool Ok = p->Store(f);
+              fclose(f);
+              if (Ok) {
+                 Files.Add(new cEpgCacheFile(p->ChannelID(), Buffer, Size));
+                 p->cached = true;
+                 }
+              else
+                 free(Buffer);
+              }
+           else
+              LOG_ERROR;
+           }
+        }
+  }
+  cString Directory = CacheDirectory();
+  if (!MakeDirs(Directory, true))
+     return;
+  int Failed = 0;
+  for (cEpgCacheFile *p = Files.First(); p; p = Files.Next(p)) {
+      cSafeFile f(AddDirectory(Directory, p->channelID.ToString()));
+      if (!f.Open() || fwrite(p->buffer, 1, p->size, f) != p->size || !f.Close()) {
+         p->failed = true;
+         Failed++;
+         }
+      }
+  cString IndexFileName = AddDirectory(Directory, EPGCACHEINDEX);
+  if (Failed) {
+     // Invalidates the cache, so that it isn't used with outdated schedules,
+     // and retries the failed ones next time:
+     esyslog("ERROR: can't write %d of %d schedules to the EPG cache", Failed, Files.Count());
+     unlink(IndexFileName);
+     cSchedulesLock SchedulesLock;
+     cSchedules *s = (cSchedules *)Schedules(SchedulesLock);
+     if (s) {
+        for (cEpgCacheFile *p = Files.First(); p; p = Files.Next(p)) {
+            if (p->failed) {
+               cSchedule *Schedule = (cSchedule *)s->GetSchedule(p->channelID);
+               if (Schedule)
+                  Schedule->cached = false;
+               }
+            }
+        }
+     }
+  else {
+     cSafeFile f(IndexFileName);
+     tEpgCacheHeader Header;
+     if (f.Open()) {
+        fwrite(&Header, sizeof(Header), 1, f);
+        f.Close();
+        }
+     }
+}
+
+void cSchedules::ClearCache(void)
+{
+  if (epgDataFileName) {
+     cString Directory = CacheDirectory();
+     if (access(Directory, F_OK) == 0)
+        RemoveFileOrDir(Directory);
      }
-  return false;
 }
 
 bool cSchedules::Read(FILE *f)
@@ -1014,21 +1937,29 @@ bool cSchedules::Read(FILE *f)
   cSchedulesLock SchedulesLock(true, 1000);
   cSchedules *s = (cSchedules *)Schedules(SchedulesLock);
   if (s) {
+     bool result;
      bool OwnFile = f == NULL;
-     if (OwnFile) {
-        if (epgDataFileName && access(epgDataFileName, R_OK) == 0) {
-           dsyslog("reading EPG data from %s", epgDataFileName);
-           if ((f = fopen(epgDataFileName, "r")) == NULL) {
-              LOG_ERROR;
-              return false;
+     if (OwnFile && ReadCache(s))
+        result = true;
+     else {
+        if (OwnFile) {
+           // The EPG data file is newer than the cache (or there is none), so the
+           // cache is rebuilt from it:
+           ClearCache();
+           if (epgDataFileName && access(epgDataFileName, R_OK) == 0) {
+              dsyslog("reading EPG data from %s", epgDataFileName);
+              if ((f = fopen(epgDataFileName, "r")) == NULL) {
+                 LOG_ERROR;
+                 return false;
+                 }
               }
+           else
+              return false;
            }
-        else
-           return false;
+        result = cSchedule::Read(f, s);
+        if (OwnFile)
+           fclose(f);
         }
-     bool result = cSchedule::Read(f, s);
-     if (OwnFile)
-        fclose(f);
      if (result) {
         // Initialize the channels' schedule pointers, so that the first WhatsOn menu will come up faster:
         for (cChannel *Channel = Channels.First(); Channel; Channel = Channels.Next(Channel))
@@ -1039,13 +1970,19 @@ bool cSchedules::Read(FILE *f)
   return false;
 }
 
+void cSchedules::HashSchedule(cSchedule *Schedule)
+{
+  Add(Schedule);
+  schedulesHashSid.Add(Schedule, Schedule->ChannelID().Sid());
+}
+
 cSchedule *cSchedules::AddSchedule(tChannelID ChannelID)
 {
   ChannelID.ClrRid();
   cSchedule *p = (cSchedule *)GetSchedule(ChannelID);
   if (!p) {
      p = new cSchedule(ChannelID);
-     Add(p);
+     HashSchedule(p);
      cChannel *channel = Channels.GetByChannelID(ChannelID);
      if (channel)
         channel->schedule = p;
@@ -1056,10 +1993,14 @@ cSchedule *cSchedules::AddSchedule(tChannelID ChannelID)
 const cSchedule *cSchedules::GetSchedule(tChannelID ChannelID) const
 {
   ChannelID.ClrRid();
-  for (cSchedule *p = First(); p; p = Next(p)) {
-      if (p->ChannelID() == ChannelID)
-         return p;
-      }
+  cList<cHashObject> *list = schedulesHashSid.GetList(ChannelID.Sid());
+  if (list) {
+     for (cHashObject *hobj = list->First(); hobj; hobj = list->Next(hobj)) {
+         cSchedule *p = (cSchedule *)hobj->Object();
+         if (p->ChannelID() == ChannelID)
+            return p;
+         }
+     }
   return NULL;
 }
 
@@ -1074,8 +2015,22 @@ const cSchedule *cSchedules::GetSchedule(const cChannel *Channel, bool AddIfMiss
      Channel->schedule = &DummySchedule;
   if (Channel->schedule == &DummySchedule && AddIfMissing) {
      cSchedule *Schedule = new cSchedule(Channel->GetChannelID());
-     ((cSchedules *)this)->Add(Schedule);
+     ((cSchedules *)this)->HashSchedule(Schedule);
      Channel->schedule = Schedule;
      }
   return Channel->schedule != &DummySchedule? Channel->schedule : NULL;
 }
+
+int cSchedules::Search(const char *Query, cVector<const cEvent *> &Events) const
+{
+  cVector<u_int64_t> Words;
+  u_int64_t Word;
+  for (const char *s = Query; (s = EpgWord(s, Word)) != NULL; )
+      Words.Append(Word);
+  int Count = 0;
+  if (Words.Size()) {
+     for (const cSchedule *p = First(); p; p = Next(p))
+         Count += p->Search(Words, Events);
+     }
+  return Count;
+}
@@ -112,30 +112,47 @@ public:
   };
 
 class cSchedules;
+class cEpgIndex;
 
 class cSchedule : public cListObject  {
+  friend class cSchedules;
 private:
   tChannelID channelID;
   cList<cEvent> events;
-  cHash<cEvent> eventsHashID;
-  cHash<cEvent> eventsHashStartTime;
+  cVector<cEvent *> eventsByID; // the hashed events, sorted by event id
+  cVector<cEvent *> eventsByStartTime; // the hashed events, sorted by start time (also used to look them up by start time)
   bool hasRunning;
   time_t modified;
   time_t presentSeen;
+  bool cached;
+  cEpgIndex *index; // built on demand by Search()
+  int EventsUpTo(time_t Time) const;
+       ///< Returns the number of events in eventsByStartTime that start at or
+       ///< before the given Time.
+  int IndexOf(const cEvent *Event) const;
+  int SearchID(tEventID EventID, bool After) const;
+       ///< Returns the index of the first event in eventsByID with an id of
+       ///< at least (or, if After is true, more than) EventID.
+  int Search(const cVector<u_int64_t> &Words, cVector<const cEvent *> &Events) const;
+  void DropIndex(void);
 public:
   cSchedule(tChannelID ChannelID);
+  ~cSchedule();
   tChannelID ChannelID(void) const { return channelID; }
   time_t Modified(void) const { return modified; }
   time_t PresentSeen(void) const { return presentSeen; }
   bool PresentSeenWithin(int Seconds) const { return time(NULL) - presentSeen < Seconds; }
-  void SetModified(void) { modified = time(NULL); }
+  void SetModified(void);
   void SetPresentSeen(void) { presentSeen = time(NULL); }
   void SetRunningStatus(cEvent *Event, int RunningStatus, cChannel *Channel = NULL);
   void ClrRunningStatus(cChannel *Channel = NULL);
   void ResetVersions(void);
   void Sort(void);
   void DropOutdated(time_t SegmentStart, time_t SegmentEnd, uchar TableID, uchar Version);
-  void Cleanup(time_t Time);
+  void Cleanup(time_t Time, cList<cEvent> *Outdated = NULL);
+       ///< Removes the events that have ended well before Time. If Outdated is
+       ///< given, they are moved there instead of being deleted, so that the
+       ///< caller can delete them after releasing the schedules lock.
   void Cleanup(void);
   cEvent *AddEvent(cEvent *Event);
   void DelEvent(cEvent *Event);
@@ -146,8 +163,17 @@ public:
   const cEvent *GetFollowingEvent(void) const;
   const cEvent *GetEvent(tEventID EventID, time_t StartTime = 0) const;
   const cEvent *GetEventAround(time_t Time) const;
+  int Search(const char *Query, cVector<const cEvent *> &Events) const;
+       ///< Appends the events that contain all the words of the given Query in
+       ///< their title, short text or description to Events, in the order of
+       ///< their start times, and returns their number. Case is ignored.
   void Dump(FILE *f, const char *Prefix = "", eDumpMode DumpMode = dmAll, time_t AtTime = 0) const;
   static bool Read(FILE *f, cSchedules *Schedules);
+  bool Store(FILE *f) const;
+       ///< Writes this schedule's events to f in the binary format of the EPG
+       ///< cache.
+  static bool Load(const uchar *Data, int Length, cSchedules *Schedules);
+       ///< Adds the schedule stored by Store() in the given Data to Schedules.
   };
 
 class cSchedulesLock {
@@ -164,6 +190,16 @@ class cSchedules : public cList<cSchedule> {
   friend class cSchedulesLock;
 private:
   cRwLock rwlock;
+  cHash<cSchedule> schedulesHashSid;
+  void HashSchedule(cSchedule *Schedule);
+  static cString CacheDirectory(void);
+  static bool ReadCache(cSchedules *Schedules);
+       ///< Reads the EPG cache, unless it is missing or older than the EPG
+       ///< data file.
+  static void WriteCache(void);
+       ///< Writes all schedules that have been modified since they were last
+       ///< written to the EPG cache.
+  static void ClearCache(void);
   static cSchedules schedules;
   static const char *epgDataFileName;
   static time_t lastCleanup;
@@ -185,6 +221,8 @@ public:
   cSchedule *AddSchedule(tChannelID ChannelID);
   const cSchedule *GetSchedule(tChannelID ChannelID) const;
   const cSchedule *GetSchedule(const cChannel *Channel, bool AddIfMissing = false) const;
+  int Search(const char *Query, cVector<const cEvent *> &Events) const;
+       ///< Same as cSchedule::Search(), for all schedules.
   };
 
 void ReportEpgBugFixStats(bool Reset = false);
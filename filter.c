@@ -71,12 +71,14 @@ cFilter::cFilter(void)
 {
   sectionHandler = NULL;
   on = false;
+  skipRepeated = false;
 }
 
 cFilter::cFilter(u_short Pid, u_char Tid, u_char Mask)
 {
   sectionHandler = NULL;
   on = false;
+  skipRepeated = false;
   Set(Pid, Tid, Mask);
 }
 
@@ -134,6 +136,17 @@ bool cFilter::Matches(u_short Pid, u_char Tid)
   return false;
 }
 
+void cFilter::SkipRepeatedSections(bool On)
+{
+  skipRepeated = On;
+}
+
+void cFilter::Reject(void)
+{
+  if (sectionHandler)
+     sectionHandler->Reject();
+}
+
 void cFilter::Set(u_short Pid, u_char Tid, u_char Mask)
 {
   Add(Pid, Tid, Mask, true);
@@ -44,6 +44,7 @@ private:
   cSectionHandler *sectionHandler;
   cList<cFilterData> data;
   bool on;
+  bool skipRepeated;
 protected:
   cFilter(void);
   cFilter(u_short Pid, u_char Tid, u_char Mask = 0xFF);
@@ -66,12 +67,26 @@ protected:
        ///< its Process() function called at any given time. It is allowed
        ///< that more than one cFilter are set up to receive the same Pid/Tid.
        ///< The Process() function must return as soon as possible.
+       ///< Every section received is delivered, unless this filter has called
+       ///< SkipRepeatedSections().
   int Source(void);
        ///< Returns the source of the data delivered to this filter.
   int Transponder(void);
        ///< Returns the transponder of the data delivered to this filter.
   const cChannel *Channel(void);
        ///< Returns the channel of the data delivered to this filter.
+  void SkipRepeatedSections(bool On = true);
+       ///< If On is true, a 'long' section (one that has a CRC) that is received
+       ///< again unchanged within a short time is not delivered to Process()
+       ///< again. This only takes effect if all filters that receive the
+       ///< section have called this function. PAT, PMT and present/following
+       ///< EIT sections are always delivered.
+  void Reject(void);
+       ///< Tells the section handler that the data given to the current call
+       ///< to Process() could not be handled (for instance because the filter
+       ///< has no room to keep it). If SkipRepeatedSections() is in effect,
+       ///< a rejected section will still be delivered the next time it is
+       ///< received. May only be called from within Process().
   bool Matches(u_short Pid, u_char Tid);
        ///< Indicates whether this filter wants to receive data from the given Pid/Tid.
   void Set(u_short Pid, u_char Tid, u_char Mask = 0xFF);
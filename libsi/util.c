@@ -264,12 +264,37 @@ u_int32_t CRC32::crc_table[256] = {
    0x933eb0bb, 0x97ffad0c, 0xafb010b1, 0xab710d06, 0xa6322bdf, 0xa2f33668,
    0xbcb4666d, 0xb8757bda, 0xb5365d03, 0xb1f740b4};
 
+// Further tables for processing eight bytes per step ("slicing-by-8"):
+// crc_slices[k][i] is the CRC of byte i followed by k + 1 zero bytes.
+u_int32_t CRC32::crc_slices[7][256];
+
+class CRC32SlicesInitializer : public CRC32 {
+public:
+   CRC32SlicesInitializer() : CRC32(0, 0) {
+      for (int i=0; i<256; i++) {
+         u_int32_t crc=crc_table[i];
+         for (int k=0; k<7; k++) {
+            crc = (crc << 8) ^ crc_table[crc >> 24];
+            crc_slices[k][i]=crc;
+         }
+      }
+   }
+};
+
+static CRC32SlicesInitializer crc32SlicesInitializer;
+
 u_int32_t CRC32::crc32 (const char *d, int len, u_int32_t crc)
 {
-   register int i;
    const unsigned char *u=(unsigned char*)d; // Saves '& 0xff'
 
-   for (i=0; i<len; i++)
+   for (; len>=8; len-=8, u+=8) {
+      crc ^= (u[0] << 24) | (u[1] << 16) | (u[2] << 8) | u[3];
+      crc = crc_slices[6][crc >> 24] ^ crc_slices[5][(crc >> 16) & 0xff]
+          ^ crc_slices[4][(crc >> 8) & 0xff] ^ crc_slices[3][crc & 0xff]
+          ^ crc_slices[2][u[4]] ^ crc_slices[1][u[5]]
+          ^ crc_slices[0][u[6]] ^ crc_table[u[7]];
+   }
+   while (len--)
       crc = (crc << 8) ^ crc_table[((crc >> 24) ^ *u++)];
 
    return crc;
@@ -27,6 +27,7 @@
 #include "status.h"
 #include "themes.h"
 #include "timers.h"
+#include "timeshift.h"
 #include "transfer.h"
 #include "vdrttxtsubshooks.h"
 #include "videodir.h"
@@ -50,7 +51,7 @@
 
 // --- cFreeDiskSpace --------------------------------------------------------
 
-#define MB_PER_MINUTE 25.75 // this is just an estimate!
+#define MB_PER_MINUTE 25.75 // this is just an estimate, used as long as no recording's size and length are known
 
 class cFreeDiskSpace {
 private:
@@ -75,7 +76,8 @@ bool cFreeDiskSpace::HasChanged(bool ForceCheck)
      int Percent = VideoDiskSpace(&FreeMB);
      lastDiskSpaceCheck = time(NULL);
      if (ForceCheck || FreeMB != lastFreeMB) {
-        int Minutes = int(double(FreeMB) / MB_PER_MINUTE);
+        double MBperMinute = Recordings.MBperMinute();
+        int Minutes = int(double(FreeMB) / (MBperMinute > 0 ? MBperMinute : MB_PER_MINUTE));
         int Hours = Minutes / 60;
         Minutes %= 60;
         freeDiskSpaceString = cString::sprintf("%s %d%%  -  %2d:%02d %s", tr("Disk"), Percent, Hours, Minutes, tr("free"));
@@ -2491,6 +2493,7 @@ void cMenuSetupDVB::Setup(void)
      Add(new cMenuEditStraItem(tr("Setup.DVB$Video display format"), &data.VideoDisplayFormat, 3, videoDisplayFormatTexts));
   Add(new cMenuEditBoolItem(tr("Setup.DVB$Use Dolby Digital"),     &data.UseDolbyDigital));
   Add(new cMenuEditStraItem(tr("Setup.DVB$Update channels"),       &data.UpdateChannels, 6, updateChannelsTexts));
+  Add(new cMenuEditBoolItem(tr("Setup.DVB$Predictive tuning"),     &data.PreTuning));
   Add(new cMenuEditIntItem( tr("Setup.DVB$Audio languages"),       &numAudioLanguages, 0, I18nLanguages()->Size()));
   for (int i = 0; i < numAudioLanguages; i++)
       Add(new cMenuEditStraItem(tr("Setup.DVB$Audio language"),    &data.AudioLanguages[i], I18nLanguages()->Size(), &I18nLanguages()->At(0)));
@@ -2751,6 +2754,8 @@ cMenuSetupRecord::cMenuSetupRecord(void)
   Add(new cMenuEditIntItem( tr("Setup.Recording$Default lifetime (d)"),      &data.DefaultLifetime, 0, MAXLIFETIME));
   Add(new cMenuEditIntItem( tr("Setup.Recording$Pause priority"),            &data.PausePriority, 0, MAXPRIORITY));
   Add(new cMenuEditIntItem( tr("Setup.Recording$Pause lifetime (d)"),        &data.PauseLifetime, 0, MAXLIFETIME));
+  Add(new cMenuEditIntItem( tr("Setup.Recording$Time shift buffer (MB)"),    &data.TimeShiftSize, 0, MAXTIMESHIFTSIZE, tr("off")));
+  Add(new cMenuEditBoolItem(tr("Setup.Recording$Time shift buffer on disk"), &data.TimeShiftFile));
   Add(new cMenuEditBoolItem(tr("Setup.Recording$Use episode name"),          &data.UseSubtitle));
   Add(new cMenuEditBoolItem(tr("Setup.Recording$Use VPS"),                   &data.UseVps));
   Add(new cMenuEditIntItem( tr("Setup.Recording$VPS margin (s)"),            &data.VpsMargin, 0));
@@ -2759,6 +2764,9 @@ cMenuSetupRecord::cMenuSetupRecord(void)
   Add(new cMenuEditIntItem( tr("Setup.Recording$Instant rec. time (min)"),   &data.InstantRecordTime, 1, MAXINSTANTRECTIME));
   Add(new cMenuEditIntItem( tr("Setup.Recording$Max. video file size (MB)"), &data.MaxVideoFileSize, MINVIDEOFILESIZE, MAXVIDEOFILESIZE));
   Add(new cMenuEditBoolItem(tr("Setup.Recording$Split edited files"),        &data.SplitEditedFiles));
+  Add(new cMenuEditIntItem( tr("Setup.Recording$Parallel editing processes"), &data.EditingJobs, 1, MAXEDITINGJOBS));
+  Add(new cMenuEditIntItem( tr("Setup.Recording$Editing bandwidth (MB/s)"),  &data.EditingBandwidth, 0, 1000, tr("off")));
+  Add(new cMenuEditIntItem( tr("Setup.Recording$Editing yields at (%)"),     &data.EditingYieldLimit, 0, 100, tr("never")));
 }
 
 // --- cMenuSetupReplay ------------------------------------------------------
@@ -2776,6 +2784,7 @@ cMenuSetupReplay::cMenuSetupReplay(void)
   Add(new cMenuEditBoolItem(tr("Setup.Replay$Multi speed mode"), &data.MultiSpeedMode));
   Add(new cMenuEditBoolItem(tr("Setup.Replay$Show replay mode"), &data.ShowReplayMode));
   Add(new cMenuEditIntItem(tr("Setup.Replay$Resume ID"), &data.ResumeID, 0, 99));
+  Add(new cMenuEditIntItem(tr("Setup.Replay$Prefetch (frames)"), &data.ReplayPrefetch, 0, MAXPREFETCHFRAMES, tr("off")));
 }
 
 void cMenuSetupReplay::Store(void)
@@ -3969,6 +3978,8 @@ void cRecordControls::Stop(const char *InstantId)
 
 bool cRecordControls::PauseLiveVideo(void)
 {
+  if (Setup.TimeShiftSize > 0 && cTimeShiftControl::Start())
+     return true;
   Skins.Message(mtStatus, tr("Pausing live video..."));
   cReplayControl::SetRecording(NULL, NULL); // make sure the new cRecordControl will set cReplayControl::LastReplayed()
   if (Start(NULL, true)) {
@@ -4355,7 +4366,7 @@ void cReplayControl::EditCut(void)
 {
   if (fileName) {
      Hide();
-     if (!cCutter::Active()) {
+     if (!cCutter::Active(fileName)) {
         if (!marks.Count())
            Skins.Message(mtError, tr("No editing marks defined!"));
         else if (!cCutter::Start(fileName))
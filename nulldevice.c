@@ -0,0 +1,82 @@
+/*
+ * nulldevice.c: A device that discards everything it is given to play
+ *
+ * See the main source file 'vdr.c' for copyright information and
+ * how to reach the author.
+ *
+ * $Id$
+ */
+
+#include "nulldevice.h"
+
+#define NULLDEVICERATE    (MEGABYTE(6) / 8) // bytes per second (a typical SD stream)
+#define NULLDEVICEBUFSIZE KILOBYTE(256)     // the amount of data the "decoder" buffers
+
+cNullDevice::cNullDevice(void)
+{
+  played = 0;
+  isyslog("device %d is a null device", DeviceNumber() + 1);
+}
+
+int cNullDevice::Ahead(void)
+{
+  // Returns the number of bytes that have been played, but not yet "decoded":
+  int64_t Decoded = int64_t(start.Elapsed()) * NULLDEVICERATE / 1000;
+  if (Decoded >= played) {
+     // the decoder ran dry, so it starts over with the next data:
+     start.Set();
+     played = 0;
+     return 0;
+     }
+  return int(played - Decoded);
+}
+
+void cNullDevice::Consume(int Length)
+{
+  Ahead();
+  played += Length;
+}
+
+bool cNullDevice::HasDecoder(void) const
+{
+  return true;
+}
+
+bool cNullDevice::SetPlayMode(ePlayMode PlayMode)
+{
+  Clear();
+  return true;
+}
+
+int cNullDevice::PlayVideo(const uchar *Data, int Length)
+{
+  Consume(Length);
+  return Length;
+}
+
+int cNullDevice::PlayAudio(const uchar *Data, int Length, uchar Id)
+{
+  Consume(Length);
+  return Length;
+}
+
+void cNullDevice::Clear(void)
+{
+  cDevice::Clear();
+  start.Set();
+  played = 0;
+}
+
+bool cNullDevice::Poll(cPoller &Poller, int TimeoutMs)
+{
+  int Bytes = Ahead() - NULLDEVICEBUFSIZE;
+  if (Bytes <= 0)
+     return true;
+  cCondWait::SleepMs(min(TimeoutMs, Bytes * 1000 / NULLDEVICERATE + 1));
+  return Ahead() < NULLDEVICEBUFSIZE;
+}
+
+bool cNullDevice::Flush(int TimeoutMs)
+{
+  return true;
+}
@@ -0,0 +1,40 @@
+/*
+ * nulldevice.h: A device that discards everything it is given to play
+ *
+ * See the main source file 'vdr.c' for copyright information and
+ * how to reach the author.
+ *
+ * $Id$
+ */
+
+#ifndef __NULLDEVICE_H
+#define __NULLDEVICE_H
+
+#include "device.h"
+
+/// The cNullDevice pretends to have an MPEG decoder, but simply discards
+/// everything it is given to play. It consumes data at the rate of a typical
+/// SD stream, so that replay behaves much like it would on real hardware.
+/// It can't receive any channels. Its purpose is to run VDR without any DVB
+/// hardware, for instance to measure how fast replay reacts to jumps (see
+/// the SVDRP command STAT REPLAY).
+
+class cNullDevice : public cDevice {
+private:
+  cTimeMs start;
+  int64_t played;
+  int Ahead(void);
+  void Consume(int Length);
+protected:
+  virtual bool SetPlayMode(ePlayMode PlayMode);
+  virtual int PlayVideo(const uchar *Data, int Length);
+  virtual int PlayAudio(const uchar *Data, int Length, uchar Id);
+public:
+  cNullDevice(void);
+  virtual bool HasDecoder(void) const;
+  virtual void Clear(void);
+  virtual bool Poll(cPoller &Poller, int TimeoutMs = 0);
+  virtual bool Flush(int TimeoutMs = 0);
+  };
+
+#endif //__NULLDEVICE_H
@@ -13,6 +13,7 @@
 #include "libsi/section.h"
 #include "libsi/descriptor.h"
 #include "thread.h"
+#include "zaptrace.h"
 
 #define PMT_SCAN_TIMEOUT  10 // seconds
 
@@ -308,6 +309,7 @@ void cPatFilter::Process(u_short Pid, u_char Tid, const u_char *Data, int Length
         return;
      if (pmt.getServiceId() != pmtSid)
         return; // skip broken PMT records
+     cZapTrace::MarkPmt(Source(), Transponder(), pmtSid);
      if (!PmtVersionChanged(pmtPid, pmt.getTableIdExtension(), pmt.getVersionNumber())) {
         lastPmtScan = 0; // this triggers the next scan
         return;
@@ -0,0 +1,140 @@
+/*
+ * pretune.c: Predictive tuning of idle devices
+ *
+ * See the main source file 'vdr.c' for copyright information and
+ * how to reach the author.
+ *
+ * $Id$
+ */
+
+#include "pretune.h"
+#include <string.h>
+#include "config.h"
+#include "eitscan.h"
+
+#define MAXCANDIDATES (2 + PRETUNEHISTORY + MAXDEVICES)
+
+static bool SameTransponder(const cChannel *Channel1, const cChannel *Channel2)
+{
+  return Channel1->Source() == Channel2->Source() && ISTRANSPONDER(Channel1->Transponder(), Channel2->Transponder());
+}
+
+// --- cPreTuner -------------------------------------------------------------
+
+cPreTuner PreTuner;
+
+cPreTuner::cPreTuner(void)
+{
+  lastCheck = 0;
+  currentChannel = 0;
+  numHistory = 0;
+}
+
+void cPreTuner::AddHistory(int Channel)
+{
+  int n = min(numHistory, PRETUNEHISTORY - 1);
+  for (int i = 0; i < numHistory; i++) {
+      if (history[i] == Channel) {
+         n = i;
+         break;
+         }
+      }
+  if (n == numHistory)
+     numHistory++;
+  memmove(history + 1, history, n * sizeof(int));
+  history[0] = Channel;
+}
+
+bool cPreTuner::MayUse(cDevice *Device)
+{
+  return Device != cDevice::ActualDevice() && !Device->Receiving() && Device->MaySwitchTransponder() && !EITScanner.UsesDevice(Device) && !EITScanner.Scans(Device);
+}
+
+void cPreTuner::Process(void)
+{
+  if (!Setup.PreTuning)
+     return;
+  time_t now = time(NULL);
+  int Current = cDevice::CurrentChannel();
+  if (Current == currentChannel && now - lastCheck < Interval)
+     return;
+  if (Current != currentChannel) {
+     if (currentChannel)
+        AddHistory(currentChannel);
+     currentChannel = Current;
+     }
+  lastCheck = now;
+  int NumDevices = cDevice::NumDevices();
+  cDevice *Devices[MAXDEVICES];
+  int NumFree = 0;
+  for (int i = 0; i < NumDevices; i++) {
+      cDevice *Device = cDevice::GetDevice(i);
+      if (Device && MayUse(Device))
+         Devices[NumFree++] = Device;
+      }
+  if (!NumFree || !Channels.Lock(false, 10))
+     return;
+  // Collect the channels that are most likely to be selected next:
+  const cChannel *Candidates[MAXCANDIDATES];
+  int NumCandidates = 0;
+  const cChannel *Channel = Channels.GetByNumber(Current);
+  if (Channel) {
+     if (const cChannel *Next = Channels.GetByNumber(Current + 1, 1))
+        Candidates[NumCandidates++] = Next;
+     if (const cChannel *Prev = Channels.GetByNumber(Current - 1, -1))
+        Candidates[NumCandidates++] = Prev;
+     }
+  for (int i = 0; i < numHistory; i++) {
+      if (const cChannel *c = Channels.GetByNumber(history[i]))
+         Candidates[NumCandidates++] = c;
+      }
+  int n = 0;
+  for (const cChannel *c = Channels.First(); c && n < MAXDEVICES; c = Channels.Next(c)) {
+      if (!c->GroupSep()) {
+         Candidates[NumCandidates++] = c;
+         n++;
+         }
+      }
+  // Reduce them to the transponders that are not yet tuned to by a device
+  // we can't use anyway (like the one used for live viewing):
+  const cChannel *Transponders[MAXCANDIDATES];
+  int NumTransponders = 0;
+  for (int i = 0; i < NumCandidates && NumTransponders < NumFree; i++) {
+      const cChannel *c = Candidates[i];
+      bool Skip = Channel && SameTransponder(c, Channel);
+      for (int j = 0; !Skip && j < NumTransponders; j++)
+          Skip = SameTransponder(c, Transponders[j]);
+      for (int j = 0; !Skip && j < NumDevices; j++) {
+          cDevice *Device = cDevice::GetDevice(j);
+          Skip = Device && !MayUse(Device) && Device->IsTunedToTransponder(c);
+          }
+      if (!Skip)
+         Transponders[NumTransponders++] = c;
+      }
+  // Keep the devices that are already tuned to one of these transponders:
+  for (int i = 0; i < NumTransponders; i++) {
+      for (int j = 0; j < NumFree; j++) {
+          if (Devices[j] && Devices[j]->IsTunedToTransponder(Transponders[i])) {
+             Devices[j] = NULL;
+             Transponders[i] = NULL;
+             break;
+             }
+          }
+      }
+  // Tune the remaining devices to the rest of them:
+  for (int i = 0; i < NumTransponders; i++) {
+      const cChannel *c = Transponders[i];
+      if (c) {
+         for (int j = 0; j < NumFree; j++) {
+             cDevice *Device = Devices[j];
+             if (Device && Device->ProvidesTransponder(c) && (!c->Ca() || c->Ca() == Device->DeviceNumber() + 1 || c->Ca() >= CA_ENCRYPTED_MIN)) {
+                dsyslog("pre-tuning device %d to transponder of channel %d", Device->DeviceNumber() + 1, c->Number());
+                Device->SwitchChannel(c, false);
+                Devices[j] = NULL;
+                break;
+                }
+             }
+         }
+      }
+  Channels.Unlock();
+}
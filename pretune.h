@@ -0,0 +1,44 @@
+/*
+ * pretune.h: Predictive tuning of idle devices
+ *
+ * See the main source file 'vdr.c' for copyright information and
+ * how to reach the author.
+ *
+ * $Id$
+ */
+
+#ifndef __PRETUNE_H
+#define __PRETUNE_H
+
+#include "channels.h"
+#include "device.h"
+
+#define PRETUNEHISTORY 8 // the number of previously viewed channels to remember
+
+/// The cPreTuner keeps idle devices tuned to the transponders of the channels
+/// that are most likely to be selected next: the channels right above and
+/// below the current one, the most recently viewed channels and finally the
+/// first channels in channels.conf. cDevice::GetDevice() prefers a device that
+/// is already tuned to the requested transponder, so that zapping to such a
+/// channel doesn't have to wait for the tuner to get a lock.
+
+class cPreTuner {
+private:
+  enum { Interval = 10 }; // seconds between checks if the channel hasn't changed
+  time_t lastCheck;
+  int currentChannel;
+  int history[PRETUNEHISTORY];
+  int numHistory;
+  void AddHistory(int Channel);
+  bool MayUse(cDevice *Device);
+public:
+  cPreTuner(void);
+  void Process(void);
+       ///< Checks whether the current channel has changed and, if so (or if
+       ///< the last check was some time ago), tunes the idle devices to the
+       ///< transponders that are most likely to be needed next.
+  };
+
+extern cPreTuner PreTuner;
+
+#endif //__PRETUNE_H
@@ -57,6 +57,11 @@ bool cReceiver::WantsPid(int Pid)
   return false;
 }
 
+uint64_t cReceiver::ReceiveTime(void)
+{
+  return device ? device->ReceiveTime() : cTimeMs::Now();
+}
+
 void cReceiver::Detach(void)
 {
   if (device)
@@ -25,6 +25,10 @@ private:
   bool WantsPid(int Pid);
 protected:
   void Detach(void);
+  uint64_t ReceiveTime(void);
+               ///< Returns the time (in ms, as given by cTimeMs::Now()) at which the
+               ///< TS packet that is currently being delivered to Receive() has been
+               ///< read by the device.
   virtual void Activate(bool On) {}
                ///< This function is called just before the cReceiver gets attached to
                ///< (On == true) or detached from (On == false) a cDevice. It can be used
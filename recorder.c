@@ -23,6 +23,8 @@
 #define MINFREEDISKSPACE    (512) // MB
 #define DISKCHECKINTERVAL   100 // seconds
 
+#define SIZEUPDATEINTERVAL   10 // seconds between updates of the recording's size in the list of recordings
+
 // --- cFileWriter -----------------------------------------------------------
 
 class cFileWriter : public cThread {
@@ -33,9 +35,13 @@ private:
   cIndexFile *index;
   uchar pictureType;
   int fileSize;
+  int previousFilesSizeMB;
   cUnbufferedFile *recordFile;
   time_t lastDiskSpaceCheck;
+  time_t lastSizeUpdate;
+  char *recordingName;
   bool RunningLowOnDiskSpace(void);
+  void UpdateFileSize(void);
   bool NextFile(void);
 protected:
   virtual void Action(void);
@@ -54,6 +60,9 @@ cFileWriter::cFileWriter(const char *FileName, cRemux *Remux, cTtxtSubsRecorderB
   pictureType = NO_PICTURE;
   fileSize = 0;
   lastDiskSpaceCheck = time(NULL);
+  lastSizeUpdate = time(NULL);
+  recordingName = strdup(FileName);
+  previousFilesSizeMB = 0;
   fileName = new cFileName(FileName, true);
   recordFile = fileName->Open();
   if (!recordFile)
@@ -68,12 +77,20 @@ cFileWriter::cFileWriter(const char *FileName, cRemux *Remux, cTtxtSubsRecorderB
 cFileWriter::~cFileWriter()
 {
   Cancel(3);
+  UpdateFileSize();
   delete index;
   delete fileName;
+  free(recordingName);
   if (ttxtSubsRecorder)
      delete ttxtSubsRecorder;
 }
 
+void cFileWriter::UpdateFileSize(void)
+{
+  Recordings.UpdateFileSize(recordingName, previousFilesSizeMB + fileSize / MEGABYTE(1), index ? index->Last() + 1 : -1);
+  lastSizeUpdate = time(NULL);
+}
+
 bool cFileWriter::RunningLowOnDiskSpace(void)
 {
   if (time(NULL) > lastDiskSpaceCheck + DISKCHECKINTERVAL) {
@@ -92,6 +109,7 @@ bool cFileWriter::NextFile(void)
   if (recordFile && pictureType == I_FRAME) { // every file shall start with an I_FRAME
      if (fileSize > MEGABYTE(Setup.MaxVideoFileSize) || RunningLowOnDiskSpace()) {
         recordFile = fileName->NextFile();
+        previousFilesSizeMB += fileSize / MEGABYTE(1);
         fileSize = 0;
         }
      }
@@ -100,6 +118,9 @@ bool cFileWriter::NextFile(void)
 
 void cFileWriter::Action(void)
 {
+  // In case we're continuing an existing recording (this is done here, so that
+  // it doesn't delay the start of the recording):
+  previousFilesSizeMB = max(DirSizeMB(recordingName), 0);
   time_t t = time(NULL);
   while (Running()) {
         int Count;
@@ -130,6 +151,8 @@ void cFileWriter::Action(void)
            else
               break;
            t = time(NULL);
+           if (t - lastSizeUpdate > SIZEUPDATEINTERVAL)
+              UpdateFileSize();
            }
         else if (time(NULL) - t > MAXBROKENTIMEOUT) {
            esyslog("ERROR: video data stream broken");
@@ -141,6 +164,9 @@ void cFileWriter::Action(void)
 
 // --- cRecorder -------------------------------------------------------------
 
+static cMutex RecordersMutex;
+static cVector<cRecorder *> Recorders;
+
 cRecorder::cRecorder(const char *FileName, tChannelID ChannelID, int Priority, int VPid, const int *APids, const int *DPids, const int *SPids, cTtxtSubsRecorderBase *tsr)
 :cReceiver(ChannelID, Priority, VPid, APids, Setup.UseDolbyDigital ? DPids : NULL, SPids)
 ,cThread("recording")
@@ -153,16 +179,35 @@ cRecorder::cRecorder(const char *FileName, tChannelID ChannelID, int Priority, i
   ringBuffer->SetTimeouts(0, 100);
   remux = new cRemux(VPid, APids, Setup.UseDolbyDigital ? DPids : NULL, SPids, true);
   writer = new cFileWriter(FileName, remux, tsr);
+  cMutexLock MutexLock(&RecordersMutex);
+  Recorders.Append(this);
 }
 
 cRecorder::~cRecorder()
 {
+  RecordersMutex.Lock();
+  for (int i = 0; i < Recorders.Size(); i++) {
+      if (Recorders[i] == this) {
+         Recorders.Remove(i);
+         break;
+         }
+      }
+  RecordersMutex.Unlock();
   Detach();
   delete writer;
   delete remux;
   delete ringBuffer;
 }
 
+int cRecorder::MaxBufferFillLevel(void)
+{
+  cMutexLock MutexLock(&RecordersMutex);
+  int Fill = 0;
+  for (int i = 0; i < Recorders.Size(); i++)
+      Fill = max(Fill, Recorders[i]->ringBuffer->FillLevel());
+  return Fill;
+}
+
 void cRecorder::Activate(bool On)
 {
   if (On) {
@@ -33,6 +33,9 @@ public:
                // Creates a new recorder for the channel with the given ChannelID and
                // the given Priority that will record the given PIDs into the file FileName.
   virtual ~cRecorder();
+  static int MaxBufferFillLevel(void);
+               // Returns the fill level (in percent) of the fullest buffer of all
+               // currently active recorders.
   };
 
 #endif //__RECORDER_H
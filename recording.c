@@ -495,6 +495,7 @@ cRecording::cRecording(cTimer *Timer, const cEvent *Event)
   fileName = NULL;
   name = NULL;
   fileSizeMB = -1; // unknown
+  numFrames = -1; // unknown
   deleted = 0;
   // set up the actual name:
   const char *Title = Event ? Event->Title() : NULL;
@@ -546,6 +547,7 @@ cRecording::cRecording(const char *FileName)
 {
   resume = RESUME_NOT_INITIALIZED;
   fileSizeMB = -1; // unknown
+  numFrames = -1; // unknown
   deleted = 0;
   titleBuffer = NULL;
   sortBuffer = NULL;
@@ -554,7 +556,7 @@ cRecording::cRecording(const char *FileName)
   char *p = strrchr(FileName, '/');
 
   name = NULL;
-  info = new cRecordingInfo;
+  info = NULL; // will be read when it is first needed
   if (p) {
      time_t now = time(NULL);
      struct tm tm_r;
@@ -570,69 +572,6 @@ cRecording::cRecording(const char *FileName)
         name[p - FileName] = 0;
         name = ExchangeChars(name, false);
         }
-     GetResume();
-     // read an optional info file:
-     cString InfoFileName = cString::sprintf("%s%s", fileName, INFOFILESUFFIX);
-     FILE *f = fopen(InfoFileName, "r");
-     if (f) {
-        if (!info->Read(f))
-           esyslog("ERROR: EPG data problem in file %s", *InfoFileName);
-        fclose(f);
-        }
-     else if (errno != ENOENT)
-        LOG_ERROR_STR(*InfoFileName);
-#ifdef SUMMARYFALLBACK
-     // fall back to the old 'summary.vdr' if there was no 'info.vdr':
-     if (isempty(info->Title())) {
-        cString SummaryFileName = cString::sprintf("%s%s", fileName, SUMMARYFILESUFFIX);
-        FILE *f = fopen(SummaryFileName, "r");
-        if (f) {
-           int line = 0;
-           char *data[3] = { NULL };
-           cReadLine ReadLine;
-           char *s;
-           while ((s = ReadLine.Read(f)) != NULL) {
-                 if (*s || line > 1) {
-                    if (data[line]) {
-                       int len = strlen(s);
-                       len += strlen(data[line]) + 1;
-                       data[line] = (char *)realloc(data[line], len + 1);
-                       strcat(data[line], "\n");
-                       strcat(data[line], s);
-                       }
-                    else
-                       data[line] = strdup(s);
-                    }
-                 else
-                    line++;
-                 }
-           fclose(f);
-           if (!data[2]) {
-              data[2] = data[1];
-              data[1] = NULL;
-              }
-           else if (data[1] && data[2]) {
-              // if line 1 is too long, it can't be the short text,
-              // so assume the short text is missing and concatenate
-              // line 1 and line 2 to be the long text:
-              int len = strlen(data[1]);
-              if (len > 80) {
-                 data[1] = (char *)realloc(data[1], len + 1 + strlen(data[2]) + 1);
-                 strcat(data[1], "\n");
-                 strcat(data[1], data[2]);
-                 free(data[2]);
-                 data[2] = data[1];
-                 data[1] = NULL;
-                 }
-              }
-           info->SetData(data[0], data[1], data[2]);
-           for (int i = 0; i < 3; i ++)
-               free(data[i]);
-           }
-        else if (errno != ENOENT)
-           LOG_ERROR_STR(*SummaryFileName);
-        }
-#endif
      }
 }
 
@@ -678,6 +617,73 @@ char *cRecording::SortName(void) const
   return sortBuffer;
 }
 
+void cRecording::ReadInfo(void) const
+{
+  info = new cRecordingInfo;
+  // read an optional info file:
+  cString InfoFileName = cString::sprintf("%s%s", FileName(), INFOFILESUFFIX);
+  FILE *f = fopen(InfoFileName, "r");
+  if (f) {
+     if (!info->Read(f))
+        esyslog("ERROR: EPG data problem in file %s", *InfoFileName);
+     fclose(f);
+     }
+  else if (errno != ENOENT)
+     LOG_ERROR_STR(*InfoFileName);
+#ifdef SUMMARYFALLBACK
+  // fall back to the old 'summary.vdr' if there was no 'info.vdr':
+  if (isempty(info->Title())) {
+     cString SummaryFileName = cString::sprintf("%s%s", FileName(), SUMMARYFILESUFFIX);
+     FILE *f = fopen(SummaryFileName, "r");
+     if (f) {
+        int line = 0;
+        char *data[3] = { NULL };
+        cReadLine ReadLine;
+        char *s;
+        while ((s = ReadLine.Read(f)) != NULL) {
+              if (*s || line > 1) {
+                 if (data[line]) {
+                    int len = strlen(s);
+                    len += strlen(data[line]) + 1;
+                    data[line] = (char *)realloc(data[line], len + 1);
+                    strcat(data[line], "\n");
+                    strcat(data[line], s);
+                    }
+                 else
+                    data[line] = strdup(s);
+                 }
+              else
+                 line++;
+              }
+        fclose(f);
+        if (!data[2]) {
+           data[2] = data[1];
+           data[1] = NULL;
+           }
+        else if (data[1] && data[2]) {
+           // if line 1 is too long, it can't be the short text,
+           // so assume the short text is missing and concatenate
+           // line 1 and line 2 to be the long text:
+           int len = strlen(data[1]);
+           if (len > 80) {
+              data[1] = (char *)realloc(data[1], len + 1 + strlen(data[2]) + 1);
+              strcat(data[1], "\n");
+              strcat(data[1], data[2]);
+              free(data[2]);
+              data[2] = data[1];
+              data[1] = NULL;
+              }
+           }
+        info->SetData(data[0], data[1], data[2]);
+        for (int i = 0; i < 3; i ++)
+            free(data[i]);
+        }
+     else if (errno != ENOENT)
+        LOG_ERROR_STR(*SummaryFileName);
+     }
+#endif
+}
+
 int cRecording::GetResume(void) const
 {
   if (resume == RESUME_NOT_INITIALIZED) {
@@ -758,6 +764,7 @@ const char *cRecording::Title(char Delimiter, bool NewIndicator, int Level) cons
 
 const char *cRecording::PrefixFileName(char Prefix)
 {
+  Info(); // makes sure the info is read from the original recording
   cString p = PrefixVideoFileName(FileName(), Prefix);
   if (*p) {
      free(fileName);
@@ -790,7 +797,7 @@ bool cRecording::WriteInfo(void)
   cString InfoFileName = cString::sprintf("%s%s", fileName, INFOFILESUFFIX);
   FILE *f = fopen(InfoFileName, "w");
   if (f) {
-     info->Write(f);
+     Info()->Write(f);
      fclose(f);
      }
   else
@@ -864,6 +871,168 @@ void cRecording::ResetResume(void) const
   resume = RESUME_NOT_INITIALIZED;
 }
 
+int cRecording::FileSizeMB(void) const
+{
+  if (fileSizeMB < 0)
+     fileSizeMB = DirSizeMB(FileName());
+  return fileSizeMB;
+}
+
+int cRecording::NumFrames(void) const
+{
+  if (numFrames < 0)
+     numFrames = cIndexFile::NumFrames(FileName());
+  return numFrames;
+}
+
+int cRecording::LengthInSeconds(void) const
+{
+  int n = NumFrames();
+  return n >= 0 ? n / FRAMESPERSEC : -1;
+}
+
+void cRecording::SetFileSize(int FileSizeMB, int NumFrames)
+{
+  fileSizeMB = FileSizeMB;
+  numFrames = NumFrames;
+}
+
+// --- cVideoDirScanner ------------------------------------------------------
+
+#define MAXSCANTHREADSPERDEVICE  2 // max. number of threads scanning the same file system at a time
+
+class cVideoDirScanJob : public cListObject {
+public:
+  char *dirName;
+  dev_t device;
+  int linkLevel;
+  cVideoDirScanJob(const char *DirName, dev_t Device, int LinkLevel) { dirName = strdup(DirName); device = Device; linkLevel = LinkLevel; }
+  virtual ~cVideoDirScanJob() { free(dirName); }
+  };
+
+class cVideoDirScanThread : public cThread {
+private:
+  cVideoDirScanner *scanner;
+protected:
+  virtual void Action(void) { scanner->Work(); }
+public:
+  cVideoDirScanThread(cVideoDirScanner *Scanner) :cThread("video directory scanner worker") { scanner = Scanner; }
+  virtual ~cVideoDirScanThread() { Cancel(3); }
+  };
+
+cVideoDirScanner::cVideoDirScanner(cRecordings *Recordings, bool Foreground)
+{
+  recordings = Recordings;
+  foreground = Foreground;
+  numThreads = 0;
+  waiting = 0;
+  for (int i = 0; i < MAXSCANTHREADS; i++)
+      threads[i] = NULL;
+}
+
+cVideoDirScanner::~cVideoDirScanner()
+{
+  for (int i = 0; i < numThreads; i++)
+      delete threads[i];
+}
+
+bool cVideoDirScanner::Running(void)
+{
+  return foreground || recordings->Running();
+}
+
+int cVideoDirScanner::Busy(dev_t Device)
+{
+  int n = 0;
+  for (cVideoDirScanJob *j = active.First(); j; j = active.Next(j)) {
+      if (j->device == Device)
+         n++;
+      }
+  return n;
+}
+
+void cVideoDirScanner::Add(const char *DirName, dev_t Device, int LinkLevel)
+{
+  cMutexLock MutexLock(&mutex);
+  // Directories on a file system nobody is working on yet go first, so that
+  // all physical disks are being scanned as early as possible:
+  cVideoDirScanJob *Job = new cVideoDirScanJob(DirName, Device, LinkLevel);
+  if (Busy(Device) == 0)
+     pending.Ins(Job);
+  else
+     pending.Add(Job);
+  if (numThreads < MAXSCANTHREADS - 1 && pending.Count() > waiting) {
+     // the thread that called Scan() is a worker, too
+     threads[numThreads] = new cVideoDirScanThread(this);
+     threads[numThreads++]->Start();
+     }
+  changed.Broadcast();
+}
+
+cVideoDirScanJob *cVideoDirScanner::Get(void)
+{
+  cMutexLock MutexLock(&mutex);
+  while (Running()) {
+        cVideoDirScanJob *Job = NULL;
+        int MinBusy = MAXSCANTHREADSPERDEVICE;
+        for (cVideoDirScanJob *j = pending.First(); j; j = pending.Next(j)) {
+            int b = Busy(j->device);
+            if (b < MinBusy) {
+               Job = j;
+               if ((MinBusy = b) == 0)
+                  break;
+               }
+            }
+        if (Job) {
+           pending.Del(Job, false);
+           active.Add(Job);
+           return Job;
+           }
+        if (!pending.Count() && !active.Count())
+           break; // all done
+        waiting++;
+        changed.TimedWait(mutex, 100);
+        waiting--;
+        }
+  changed.Broadcast();
+  return NULL;
+}
+
+void cVideoDirScanner::Done(cVideoDirScanJob *Job)
+{
+  cMutexLock MutexLock(&mutex);
+  active.Del(Job);
+  changed.Broadcast();
+}
+
+void cVideoDirScanner::Work(void)
+{
+  while (cVideoDirScanJob *Job = Get()) {
+        recordings->ScanVideoDir(Job->dirName, this, Job->linkLevel);
+        Done(Job);
+        }
+}
+
+void cVideoDirScanner::Scan(const char *DirName)
+{
+  struct stat st;
+  if (stat(DirName, &st) == 0) {
+     Add(DirName, st.st_dev, 0);
+     Work();
+     }
+}
+
+// --- cFileSizeUpdate -------------------------------------------------------
+
+class cFileSizeUpdate : public cListObject {
+public:
+  char *fileName;
+  int fileSizeMB;
+  int numFrames;
+  cFileSizeUpdate(const char *FileName) { fileName = strdup(FileName); fileSizeMB = numFrames = -1; }
+  ~cFileSizeUpdate() { free(fileName); }
+  };
+
 // --- cRecordings -----------------------------------------------------------
 
 cRecordings Recordings;
@@ -902,14 +1071,20 @@ void cRecordings::Refresh(bool Foreground)
   Clear();
   ChangeState();
   Unlock();
-  ScanVideoDir(VideoDirectory, Foreground);
+  cVideoDirScanner VideoDirScanner(this, Foreground);
+  VideoDirScanner.Scan(VideoDirectory);
+  // the scanner threads add recordings in no particular order:
+  Lock();
+  Sort();
+  ChangeState();
+  Unlock();
 }
 
-void cRecordings::ScanVideoDir(const char *DirName, bool Foreground, int LinkLevel)
+void cRecordings::ScanVideoDir(const char *DirName, cVideoDirScanner *Scanner, int LinkLevel)
 {
   cReadDir d(DirName);
   struct dirent *e;
-  while ((Foreground || Running()) && (e = d.Next()) != NULL) {
+  while (Scanner->Running() && (e = d.Next()) != NULL) {
         if (strcmp(e->d_name, ".") && strcmp(e->d_name, "..")) {
            char *buffer = strdup(AddDirectory(DirName, e->d_name));
            struct stat st;
@@ -935,20 +1110,20 @@ void cRecordings::ScanVideoDir(const char *DirName, bool Foreground, int LinkLev
                  if (endswith(buffer, deleted ? DELEXT : RECEXT)) {
                     cRecording *r = new cRecording(buffer);
                     if (r->Name()) {
+                       if (deleted) {
+                          r->FileSizeMB(); // determines the size while we're in the background
+                          r->deleted = time(NULL);
+                          }
                        Lock();
                        Add(r);
                        ChangeState();
                        Unlock();
-                       if (deleted) {
-                          r->fileSizeMB = DirSizeMB(buffer);
-                          r->deleted = time(NULL);
-                          }
                        }
                     else
                        delete r;
                     }
                  else
-                    ScanVideoDir(buffer, Foreground, LinkLevel + Link);
+                    Scanner->Add(buffer, st.st_dev, LinkLevel + Link);
                  }
               }
            free(buffer);
@@ -1020,12 +1195,13 @@ void cRecordings::DelByName(const char *FileName)
   LOCK_THREAD;
   cRecording *recording = GetByName(FileName);
   if (recording) {
+     ApplyFileSizeUpdates();
      cThreadLock DeletedRecordingsLock(&DeletedRecordings);
      Del(recording, false);
      char *ext = strrchr(recording->FileName(), '.');
      if (ext) {
         strncpy(ext, DELEXT, strlen(ext));
-        recording->fileSizeMB = DirSizeMB(recording->FileName());
+        recording->FileSizeMB();
         recording->deleted = time(NULL);
         DeletedRecordings.Add(recording);
         }
@@ -1036,6 +1212,29 @@ void cRecordings::DelByName(const char *FileName)
      }
 }
 
+void cRecordings::UpdateFileSize(const char *FileName, int FileSizeMB, int NumFrames)
+{
+  cMutexLock MutexLock(&fileSizeMutex);
+  cFileSizeUpdate *fsu = fileSizeUpdates.First();
+  while (fsu && strcmp(fsu->fileName, FileName) != 0)
+        fsu = fileSizeUpdates.Next(fsu);
+  if (!fsu)
+     fileSizeUpdates.Add(fsu = new cFileSizeUpdate(FileName));
+  fsu->fileSizeMB = FileSizeMB;
+  fsu->numFrames = NumFrames;
+}
+
+void cRecordings::ApplyFileSizeUpdates(void)
+{
+  cMutexLock MutexLock(&fileSizeMutex);
+  for (cFileSizeUpdate *fsu = fileSizeUpdates.First(); fsu; fsu = fileSizeUpdates.Next(fsu)) {
+      cRecording *recording = GetByName(fsu->fileName);
+      if (recording)
+         recording->SetFileSize(fsu->fileSizeMB, fsu->numFrames);
+      }
+  fileSizeUpdates.Clear();
+}
+
 int cRecordings::TotalFileSizeMB(void)
 {
   int size = 0;
@@ -1047,6 +1246,22 @@ int cRecordings::TotalFileSizeMB(void)
   return size;
 }
 
+double cRecordings::MBperMinute(void)
+{
+  int size = 0;
+  int length = 0;
+  LOCK_THREAD;
+  ApplyFileSizeUpdates();
+  for (cRecording *recording = First(); recording; recording = Next(recording)) {
+      // only the cached values are used, so that this doesn't walk through any directories:
+      if (recording->fileSizeMB > 0 && recording->numFrames >= FRAMESPERSEC * 60 && IsOnVideoDirectoryFileSystem(recording->FileName())) {
+         size += recording->fileSizeMB;
+         length += recording->numFrames / FRAMESPERSEC;
+         }
+      }
+  return (size && length) ? double(size) * 60 / length : -1;
+}
+
 void cRecordings::ResetResume(const char *ResumeFileName)
 {
   LOCK_THREAD;
@@ -1259,6 +1474,14 @@ cIndexFile::~cIndexFile()
   free(index);
 }
 
+int cIndexFile::NumFrames(const char *FileName)
+{
+  struct stat buf;
+  if (stat(cString::sprintf("%s%s", FileName, INDEXFILESUFFIX), &buf) == 0)
+     return buf.st_size / sizeof(tIndex);
+  return -1;
+}
+
 bool cIndexFile::CatchUp(int Index)
 {
   // returns true unless something really goes wrong, so that 'index' becomes NULL
@@ -71,12 +71,14 @@ private:
   mutable char *fileName;
   mutable char *name;
   mutable int fileSizeMB;
-  cRecordingInfo *info;
+  mutable int numFrames;
+  mutable cRecordingInfo *info;
   cRecording(const cRecording&); // can't copy cRecording
   cRecording &operator=(const cRecording &); // can't assign cRecording
   static char *StripEpisodeName(char *s);
   char *SortName(void) const;
   int GetResume(void) const;
+  void ReadInfo(void) const;
 public:
   time_t start;
   int priority;
@@ -89,7 +91,19 @@ public:
   const char *Name(void) const { return name; }
   const char *FileName(void) const;
   const char *Title(char Delimiter = ' ', bool NewIndicator = false, int Level = -1) const;
-  const cRecordingInfo *Info(void) const { return info; }
+  const cRecordingInfo *Info(void) const { if (!info) ReadInfo(); return info; }
+       ///< The info file of a recording is read only upon the first call to this function.
+  int FileSizeMB(void) const;
+       ///< Returns the total size of this recording's files in MB, or -1 if it can't
+       ///< be determined. The directory is only inspected upon the first call, later
+       ///< calls return the cached value, which is kept up to date by SetFileSize().
+  int NumFrames(void) const;
+       ///< Returns the number of frames in this recording (as recorded in its index
+       ///< file), or -1 if this is unknown. The value is cached like FileSizeMB().
+  int LengthInSeconds(void) const;
+       ///< Returns the length of this recording in seconds, or -1 if this is unknown.
+  void SetFileSize(int FileSizeMB, int NumFrames);
+       ///< Sets the cached size and number of frames of this recording.
   const char *PrefixFileName(char Prefix);
   int HierarchyLevels(void) const;
   void ResetResume(void) const;
@@ -108,15 +122,58 @@ public:
        // Returns false in case of error
   };
 
+#define MAXSCANTHREADS  8 // max. number of threads scanning the video directory
+
+class cRecordings;
+class cVideoDirScanJob;
+class cVideoDirScanThread;
+
+class cVideoDirScanner {
+private:
+  cRecordings *recordings;
+  bool foreground;
+  cMutex mutex;
+  cCondVar changed;
+  cList<cVideoDirScanJob> pending;
+  cList<cVideoDirScanJob> active;
+  cVideoDirScanThread *threads[MAXSCANTHREADS];
+  int numThreads;
+  int waiting;
+  int Busy(dev_t Device);
+  cVideoDirScanJob *Get(void);
+  void Done(cVideoDirScanJob *Job);
+public:
+  cVideoDirScanner(cRecordings *Recordings, bool Foreground);
+  ~cVideoDirScanner();
+  void Scan(const char *DirName);
+       ///< Scans the video directory tree starting at DirName. Each subdirectory
+       ///< is handed to a pool of worker threads, with a limited number of threads
+       ///< working on the same file system at any given time, so that the scan of
+       ///< a video directory distributed over several disks (or a high latency
+       ///< network file system) runs in parallel. Returns when the whole tree
+       ///< has been scanned.
+  void Add(const char *DirName, dev_t Device, int LinkLevel);
+  void Work(void);
+  bool Running(void);
+  };
+
+class cFileSizeUpdate;
+
 class cRecordings : public cList<cRecording>, public cThread {
+  friend class cVideoDirScanner;
 private:
   static char *updateFileName;
   bool deleted;
   time_t lastUpdate;
   int state;
+  cMutex fileSizeMutex;
+  cList<cFileSizeUpdate> fileSizeUpdates;
   const char *UpdateFileName(void);
+  void ApplyFileSizeUpdates(void);
+       ///< Hands the sizes reported through UpdateFileSize() to the recordings.
+       ///< Must be called with the list locked.
   void Refresh(bool Foreground = false);
-  void ScanVideoDir(const char *DirName, bool Foreground = false, int LinkLevel = 0);
+  void ScanVideoDir(const char *DirName, cVideoDirScanner *Scanner, int LinkLevel = 0);
 protected:
   void Action(void);
 public:
@@ -143,7 +200,18 @@ public:
   cRecording *GetByName(const char *FileName);
   void AddByName(const char *FileName, bool TriggerUpdate = true);
   void DelByName(const char *FileName);
+  void UpdateFileSize(const char *FileName, int FileSizeMB, int NumFrames);
+       ///< Updates the cached size and number of frames of the recording with the
+       ///< given FileName. This is called by whoever writes to a recording, so that
+       ///< nobody else needs to walk through its directory to find out about these.
+       ///< It doesn't lock the list of recordings (which may be held for a long
+       ///< time by a scan of the video directory), the values are handed to the
+       ///< recording the next time they are needed.
   int TotalFileSizeMB(void); ///< Only for deleted recordings!
+  double MBperMinute(void);
+       ///< Returns the average number of MB per minute of the recordings on the
+       ///< video directory's file system whose size and length are already known,
+       ///< or -1 if there are none.
   };
 
 extern cRecordings Recordings;
@@ -216,6 +284,10 @@ public:
   int GetNextIFrame(int Index, bool Forward, uchar *FileNumber = NULL, int *FileOffset = NULL, int *Length = NULL, bool StayOffEnd = false);
   int Get(uchar FileNumber, int FileOffset);
   int Last(void) { CatchUp(); return last; }
+  static int NumFrames(const char *FileName);
+       ///< Returns the number of frames in the index file of the recording with the
+       ///< given FileName (determined from the index file's size), or -1 if there
+       ///< is no index file.
   int GetResume(void) { return resumeFile.Read(); }
   bool StoreResume(int Index) { return resumeFile.Save(Index); }
   bool IsStillRecording(void);
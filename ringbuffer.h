@@ -41,6 +41,8 @@ public:
   virtual ~cRingBuffer();
   void SetTimeouts(int PutTimeout, int GetTimeout);
   void ReportOverflow(int Bytes);
+  int FillLevel(void) { return Available() * 100 / Size(); }
+      ///< Returns the percentage of this ring buffer that is currently in use.
   };
 
 class cRingBufferLinear : public cRingBuffer {
@@ -8,11 +8,19 @@
  */
 
 #include "sections.h"
+#include <fcntl.h>
+#include <sys/epoll.h>
 #include <unistd.h>
 #include "channels.h"
 #include "device.h"
 #include "thread.h"
 
+#define MAXSECTIONEVENTS 16 // the maximum number of filter handles served per wakeup
+#define MAXSECTIONREADS   8 // the maximum number of sections read from one filter handle per wakeup
+
+#define SECTIONCACHETIMEOUT 120 // seconds after which an unchanged section is processed again
+#define MAXSECTIONCACHE   32768 // the maximum number of sections remembered per device
+
 // --- cFilterHandle----------------------------------------------------------
 
 class cFilterHandle : public cListObject {
@@ -20,7 +28,10 @@ public:
   cFilterData filterData;
   int handle;
   int used;
+  cVector<cFilter *> *dispatch[256]; // the filters that want sections with a given table id from this handle (built on demand)
   cFilterHandle(const cFilterData &FilterData);
+  ~cFilterHandle();
+  void ClearDispatch(void);
   };
 
 cFilterHandle::cFilterHandle(const cFilterData &FilterData)
@@ -28,6 +39,124 @@ cFilterHandle::cFilterHandle(const cFilterData &FilterData)
   filterData = FilterData;
   handle = -1;
   used = 0;
+  memset(dispatch, 0, sizeof(dispatch));
+}
+
+cFilterHandle::~cFilterHandle()
+{
+  ClearDispatch();
+}
+
+void cFilterHandle::ClearDispatch(void)
+{
+  for (int i = 0; i < 256; i++) {
+      delete dispatch[i];
+      dispatch[i] = NULL;
+      }
+}
+
+// --- cSectionCache ---------------------------------------------------------
+
+class cSectionCacheEntry : public cListObject {
+public:
+  u_short pid;
+  u_char tid;
+  u_short tidExt;
+  u_char section;
+  uint32_t crc;
+  time_t seen;
+  };
+
+class cSectionCache {
+private:
+  cList<cSectionCacheEntry> entries;
+  cHash<cSectionCacheEntry> hash;
+public:
+  int hits, misses;
+  cSectionCache(void);
+  void Clear(void);
+  int Count(void) { return entries.Count(); }
+  bool Repeated(u_short Pid, const u_char *Data, int Length);
+       ///< Returns true if the section in Data is identical to the one with
+       ///< the same PID, table id, table id extension and section number
+       ///< received earlier, so that it need not be processed again.
+  void Forget(u_short Pid, const u_char *Data, int Length);
+       ///< Makes sure the section in Data is not considered Repeated() the
+       ///< next time it is received.
+  };
+
+cSectionCache::cSectionCache(void)
+:hash(4096)
+{
+  hits = misses = 0;
+}
+
+void cSectionCache::Clear(void)
+{
+  hash.Clear();
+  entries.Clear();
+}
+
+bool cSectionCache::Repeated(u_short Pid, const u_char *Data, int Length)
+{
+  if (Length < 12 || !(Data[1] & 0x80))
+     return false; // only 'long' sections have a CRC
+  u_char Tid = Data[0];
+  if (Tid == 0x00 || Tid == 0x02 || Tid == 0x4E || Tid == 0x4F)
+     return false; // PAT, PMT and present/following EIT are expected on every repetition
+  u_short TidExt = (Data[3] << 8) | Data[4];
+  u_char Section = Data[6];
+  const u_char *p = Data + Length - 4;
+  uint32_t Crc = (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+  unsigned int Id = (((Pid << 8) | Tid) << 16 | TidExt) ^ (Section << 5);
+  time_t Now = time(NULL);
+  if (cList<cHashObject> *list = hash.GetList(Id)) {
+     for (cHashObject *hob = list->First(); hob; hob = list->Next(hob)) {
+         cSectionCacheEntry *e = (cSectionCacheEntry *)hob->Object();
+         if (e->pid == Pid && e->tid == Tid && e->tidExt == TidExt && e->section == Section) {
+            if (e->crc == Crc && Now - e->seen < SECTIONCACHETIMEOUT) {
+               hits++;
+               return true;
+               }
+            e->crc = Crc;
+            e->seen = Now;
+            misses++;
+            return false;
+            }
+         }
+     }
+  if (entries.Count() >= MAXSECTIONCACHE)
+     Clear();
+  cSectionCacheEntry *e = new cSectionCacheEntry;
+  e->pid = Pid;
+  e->tid = Tid;
+  e->tidExt = TidExt;
+  e->section = Section;
+  e->crc = Crc;
+  e->seen = Now;
+  entries.Add(e);
+  hash.Add(e, Id);
+  misses++;
+  return false;
+}
+
+void cSectionCache::Forget(u_short Pid, const u_char *Data, int Length)
+{
+  if (Length < 12 || !(Data[1] & 0x80))
+     return;
+  u_char Tid = Data[0];
+  u_short TidExt = (Data[3] << 8) | Data[4];
+  u_char Section = Data[6];
+  unsigned int Id = (((Pid << 8) | Tid) << 16 | TidExt) ^ (Section << 5);
+  if (cList<cHashObject> *list = hash.GetList(Id)) {
+     for (cHashObject *hob = list->First(); hob; hob = list->Next(hob)) {
+         cSectionCacheEntry *e = (cSectionCacheEntry *)hob->Object();
+         if (e->pid == Pid && e->tid == Tid && e->tidExt == TidExt && e->section == Section) {
+            e->seen = 0;
+            return;
+            }
+         }
+     }
 }
 
 // --- cSectionHandlerPrivate ------------------------------------------------
@@ -35,6 +164,10 @@ cFilterHandle::cFilterHandle(const cFilterData &FilterData)
 class cSectionHandlerPrivate {
 public:
   cChannel channel;
+  cSectionCache cache;
+  int epollFd;
+  int dispatchCount;
+  bool rejected;
   };
 
 // --- cSectionHandler -------------------------------------------------------
@@ -43,6 +176,11 @@ cSectionHandler::cSectionHandler(cDevice *Device)
 :cThread("section handler")
 {
   shp = new cSectionHandlerPrivate;
+  shp->epollFd = epoll_create(MAXSECTIONEVENTS);
+  if (shp->epollFd < 0)
+     LOG_ERROR;
+  shp->dispatchCount = -1;
+  shp->rejected = false;
   device = Device;
   statusCount = 0;
   on = false;
@@ -57,6 +195,8 @@ cSectionHandler::~cSectionHandler()
   cFilter *fi;
   while ((fi = filters.First()) != NULL)
         Detach(fi);
+  if (shp->epollFd >= 0)
+     close(shp->epollFd);
   delete shp;
 }
 
@@ -90,6 +230,13 @@ void cSectionHandler::Add(const cFilterData *FilterData)
         fh = new cFilterHandle(*FilterData);
         fh->handle = handle;
         filterHandles.Add(fh);
+        // Action() reads several sections per wakeup, so it must not block:
+        fcntl(handle, F_SETFL, fcntl(handle, F_GETFL) | O_NONBLOCK);
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = fh;
+        if (epoll_ctl(shp->epollFd, EPOLL_CTL_ADD, handle, &ev) < 0)
+           LOG_ERROR;
         }
      }
   if (fh)
@@ -105,6 +252,7 @@ void cSectionHandler::Del(const cFilterData *FilterData)
   for (fh = filterHandles.First(); fh; fh = filterHandles.Next(fh)) {
       if (fh->filterData.Is(FilterData->pid, FilterData->tid, FilterData->mask)) {
          if (--fh->used <= 0) {
+            epoll_ctl(shp->epollFd, EPOLL_CTL_DEL, fh->handle, NULL);
             device->CloseFilter(fh->handle);
             filterHandles.Del(fh);
             break;
@@ -135,6 +283,46 @@ void cSectionHandler::Detach(cFilter *Filter)
   Unlock();
 }
 
+void cSectionHandler::Reject(void)
+{
+  shp->rejected = true;
+}
+
+cVector<cFilter *> *cSectionHandler::Dispatch(cFilterHandle *FilterHandle, u_char Tid)
+{
+  if (shp->dispatchCount != statusCount) {
+     for (cFilterHandle *fh = filterHandles.First(); fh; fh = filterHandles.Next(fh))
+         fh->ClearDispatch();
+     shp->dispatchCount = statusCount;
+     }
+  cVector<cFilter *> *Filters = FilterHandle->dispatch[Tid];
+  if (!Filters) {
+     Filters = FilterHandle->dispatch[Tid] = new cVector<cFilter *>(4);
+     u_short Pid = FilterHandle->filterData.pid;
+     for (cFilter *fi = filters.First(); fi; fi = filters.Next(fi)) {
+         if (fi->Matches(Pid, Tid))
+            Filters->Append(fi);
+         }
+     }
+  return Filters;
+}
+
+void cSectionHandler::GetStatistics(int &Hits, int &Misses, int &Entries)
+{
+  Lock();
+  Hits = shp->cache.hits;
+  Misses = shp->cache.misses;
+  Entries = shp->cache.Count();
+  Unlock();
+}
+
+void cSectionHandler::ClearStatistics(void)
+{
+  Lock();
+  shp->cache.hits = shp->cache.misses = 0;
+  Unlock();
+}
+
 void cSectionHandler::SetChannel(const cChannel *Channel)
 {
   Lock();
@@ -148,6 +336,7 @@ void cSectionHandler::SetStatus(bool On)
   if (on != On) {
      if (!On || device->HasLock()) {
         statusCount++;
+        shp->cache.Clear(); // sections from a different transponder
         for (cFilter *fi = filters.First(); fi; fi = filters.Next(fi)) {
             fi->SetStatus(false);
             if (On)
@@ -170,55 +359,61 @@ void cSectionHandler::Action(void)
         Lock();
         if (waitForLock)
            SetStatus(true);
-        int NumFilters = filterHandles.Count();
-        pollfd pfd[NumFilters];
-        for (cFilterHandle *fh = filterHandles.First(); fh; fh = filterHandles.Next(fh)) {
-            int i = fh->Index();
-            pfd[i].fd = fh->handle;
-            pfd[i].events = POLLIN;
-            pfd[i].revents = 0;
-            }
+        bool WaitForLock = waitForLock;
         int oldStatusCount = statusCount;
         Unlock();
 
-        if (poll(pfd, NumFilters, 1000) > 0) {
+        if (WaitForLock) {
+           device->HasLock(1000); // returns as soon as the device gets a lock
+           continue;
+           }
+
+        epoll_event Events[MAXSECTIONEVENTS];
+        int n = epoll_wait(shp->epollFd, Events, MAXSECTIONEVENTS, 1000);
+        if (n > 0) {
            bool DeviceHasLock = device->HasLock();
            if (!DeviceHasLock)
               cCondWait::SleepMs(100);
-           for (int i = 0; i < NumFilters; i++) {
-               if (pfd[i].revents & POLLIN) {
-                  cFilterHandle *fh = NULL;
-                  LOCK_THREAD;
-                  if (statusCount != oldStatusCount)
-                     break;
-                  for (fh = filterHandles.First(); fh; fh = filterHandles.Next(fh)) {
-                      if (pfd[i].fd == fh->handle)
-                         break;
+           for (int i = 0; i < n; i++) {
+               LOCK_THREAD;
+               cFilterHandle *fh = (cFilterHandle *)Events[i].data.ptr;
+               for (int j = 0; j < MAXSECTIONREADS; j++) {
+                   if (statusCount != oldStatusCount)
+                      break; // filter handles may have been deleted
+                   // Read section data:
+                   unsigned char buf[4096]; // max. allowed size for any EIT section
+                   int r = safe_read(fh->handle, buf, sizeof(buf));
+                   if (r <= 0)
+                      break;
+                   if (!DeviceHasLock)
+                      continue; // we do the read anyway, to flush any data that might have come from a different transponder
+                   if (r > 3) { // minimum number of bytes necessary to get section length
+                      int len = (((buf[1] & 0x0F) << 8) | (buf[2] & 0xFF)) + 3;
+                      if (len == r) {
+                         // Distribute data to the interested filters:
+                         int pid = fh->filterData.pid;
+                         int tid = buf[0];
+                         cVector<cFilter *> *Filters = Dispatch(fh, tid);
+                         bool SkipRepeated = Filters->Size() > 0;
+                         for (int k = 0; k < Filters->Size() && SkipRepeated; k++)
+                             SkipRepeated = (*Filters)[k]->skipRepeated;
+                         if (SkipRepeated && shp->cache.Repeated(pid, buf, len))
+                            continue;
+                         shp->rejected = false;
+                         for (int k = 0; k < Filters->Size(); k++) {
+                             (*Filters)[k]->Process(pid, tid, buf, len);
+                             if (statusCount != oldStatusCount)
+                                break; // the filter setup has changed, so Filters and fh may have been deleted
+                             }
+                         if (shp->rejected)
+                            shp->cache.Forget(pid, buf, len);
+                         }
+                      else if (time(NULL) - lastIncompleteSection > 10) { // log them only every 10 seconds
+                         dsyslog("read incomplete section - len = %d, r = %d", len, r);
+                         lastIncompleteSection = time(NULL);
+                         }
                       }
-                  if (fh) {
-                     // Read section data:
-                     unsigned char buf[4096]; // max. allowed size for any EIT section
-                     int r = safe_read(fh->handle, buf, sizeof(buf));
-                     if (!DeviceHasLock)
-                        continue; // we do the read anyway, to flush any data that might have come from a different transponder
-                     if (r > 3) { // minimum number of bytes necessary to get section length
-                        int len = (((buf[1] & 0x0F) << 8) | (buf[2] & 0xFF)) + 3;
-                        if (len == r) {
-                           // Distribute data to all attached filters:
-                           int pid = fh->filterData.pid;
-                           int tid = buf[0];
-                           for (cFilter *fi = filters.First(); fi; fi = filters.Next(fi)) {
-                               if (fi->Matches(pid, tid))
-                                  fi->Process(pid, tid, buf, len);
-                               }
-                           }
-                        else if (time(NULL) - lastIncompleteSection > 10) { // log them only every 10 seconds
-                           dsyslog("read incomplete section - len = %d, r = %d", len, r);
-                           lastIncompleteSection = time(NULL);
-                           }
-                        }
-                     }
-                  }
+                   }
                }
            }
         }
@@ -32,6 +32,11 @@ private:
   cList<cFilterHandle> filterHandles;
   void Add(const cFilterData *FilterData);
   void Del(const cFilterData *FilterData);
+  cVector<cFilter *> *Dispatch(cFilterHandle *FilterHandle, u_char Tid);
+       ///< Returns the filters that want sections with the given Tid from
+       ///< FilterHandle. The result is cached until the filter setup changes.
+  void Reject(void);
+       ///< Called by a filter that could not process the current section.
   virtual void Action(void);
 public:
   cSectionHandler(cDevice *Device);
@@ -43,6 +48,12 @@ public:
   void Detach(cFilter *Filter);
   void SetChannel(const cChannel *Channel);
   void SetStatus(bool On);
+  void GetStatistics(int &Hits, int &Misses, int &Entries);
+       ///< Returns the number of sections that have been dropped because they
+       ///< were unchanged repetitions (Hits), the number of sections that have
+       ///< been handed to the filters (Misses), and the number of sections
+       ///< currently remembered (Entries).
+  void ClearStatistics(void);
   };
 
 #endif //__SECTIONS_H
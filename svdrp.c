@@ -38,7 +38,9 @@
 #include "skins.h"
 #include "timers.h"
 #include "tools.h"
+#include "transfer.h"
 #include "videodir.h"
+#include "zaptrace.h"
 
 // --- cSocket ---------------------------------------------------------------
 
@@ -202,6 +204,10 @@ const char *HelpPages[] = {
   "    Edit the recording with the given number. Before a recording can be\n"
   "    edited, an LSTR command must have been executed in order to retrieve\n"
   "    the recording numbers.",
+  "FNDE <words>\n"
+  "    Find the events that contain all of the given words in their title, short\n"
+  "    text or description (ignoring case), and list them in the same format as\n"
+  "    the LSTE command.",
   "GRAB <filename> [ <quality> [ <sizex> <sizey> ] ]\n"
   "    Grab the current frame and save it to the given file. Images can\n"
   "    be stored as JPEG or PNM, depending on the given file name extension.\n"
@@ -300,7 +306,27 @@ const char *HelpPages[] = {
   "    Forces an EPG scan. If this is a single DVB device system, the scan\n"
   "    will be done on the primary device unless it is currently recording.",
   "STAT disk\n"
-  "    Return information about disk usage (total, free, percent).",
+  "    Return information about disk usage (total, free, percent).\n"
+  "STAT replay [ clear ]\n"
+  "    Return the time (in ms) it took replay sessions to show the first frame\n"
+  "    after a jump, a change of speed or when resuming, and the time spent in\n"
+  "    the individual steps. The option 'clear' resets these statistics.\n"
+  "STAT sections [ clear ]\n"
+  "    Return the number of sections each device has dropped because they were\n"
+  "    unchanged repetitions, and the number it has handed to the section\n"
+  "    filters. The option 'clear' resets these counters.\n"
+  "STAT switch [ clear ]\n"
+  "    Return the time (in ms) from the beginning of a live channel switch until\n"
+  "    a device has been selected, a CAM has been assigned, the tuner has a lock,\n"
+  "    the section handler has been restarted, the PMT has been received and the\n"
+  "    first video packet and I-frame have been delivered, per device and per\n"
+  "    type of source, over the last 100 channel switches. The option 'clear'\n"
+  "    resets these statistics.\n"
+  "STAT transfer [ clear ]\n"
+  "    Return the time (in ms) it took data received in transfer mode to be\n"
+  "    handed to the output device, the current limit for buffered data and\n"
+  "    the number of times the buffers have been cleared. The option 'clear'\n"
+  "    resets the time statistics.",
   "UPDT <settings>\n"
   "    Updates a timer. Settings must be in the same format as returned\n"
   "    by the LSTT command. If a timer with the same channel, day, start\n"
@@ -571,6 +597,7 @@ void cSVDRP::CmdCLRE(const char *Option)
                }
            if (Schedule) {
               Schedule->Cleanup(INT_MAX);
+              s->SetModified(Schedule);
               Reply(250, "EPG data of channel \"%s\" cleared", Option);
               }
            else {
@@ -702,7 +729,7 @@ void cSVDRP::CmdEDIT(const char *Option)
         if (recording) {
            cMarks Marks;
            if (Marks.Load(recording->FileName()) && Marks.Count()) {
-              if (!cCutter::Active()) {
+              if (!cCutter::Active(recording->FileName())) {
                  if (cCutter::Start(recording->FileName()))
                     Reply(250, "Editing recording \"%s\" [%s]", Option, recording->Title());
                  else
@@ -724,6 +751,19 @@ void cSVDRP::CmdEDIT(const char *Option)
      Reply(501, "Missing recording number");
 }
 
+void cSVDRP::CmdFNDE(const char *Option)
+{
+  if (*Option) {
+     // Like with LSTE, the events are sent after releasing the schedules lock:
+     char *Buffer = NULL;
+     size_t Size = 0;
+     if (FindEpg(Option, &Buffer, &Size))
+        SendEpg(Buffer, Size);
+     }
+  else
+     Reply(501, "Missing search words");
+}
+
 void cSVDRP::CmdGRAB(const char *Option)
 {
   const char *FileName = NULL;
@@ -948,14 +988,14 @@ void cSVDRP::CmdLSTC(const char *Option)
      Reply(550, "No channels defined");
 }
 
-void cSVDRP::CmdLSTE(const char *Option)
+bool cSVDRP::DumpEpg(const char *Option, char **Buffer, size_t *Size, eDumpMode &DumpMode, time_t &AtTime)
 {
   cSchedulesLock SchedulesLock;
   const cSchedules *Schedules = cSchedules::Schedules(SchedulesLock);
   if (Schedules) {
      const cSchedule* Schedule = NULL;
-     eDumpMode DumpMode = dmAll;
-     time_t AtTime = 0;
+     DumpMode = dmAll;
+     AtTime = 0;
      if (*Option) {
         char buf[strlen(Option) + 1];
         strcpy(buf, Option);
@@ -974,12 +1014,12 @@ void cSVDRP::CmdLSTE(const char *Option)
                        AtTime = strtol(p, NULL, 10);
                     else {
                        Reply(501, "Invalid time");
-                       return;
+                       return false;
                        }
                     }
                  else {
                     Reply(501, "Missing time");
-                    return;
+                    return false;
                     }
                  }
               else if (!Schedule) {
@@ -992,43 +1032,115 @@ void cSVDRP::CmdLSTE(const char *Option)
                     Schedule = Schedules->GetSchedule(Channel);
                     if (!Schedule) {
                        Reply(550, "No schedule found");
-                       return;
+                       return false;
                        }
                     }
                  else {
                     Reply(550, "Channel \"%s\" not defined", p);
-                    return;
+                    return false;
                     }
                  }
               else {
                  Reply(501, "Unknown option: \"%s\"", p);
-                 return;
+                 return false;
                  }
               p = strtok_r(NULL, delim, &strtok_next);
               }
         }
-     int fd = dup(file);
-     if (fd) {
-        FILE *f = fdopen(fd, "w");
-        if (f) {
-           if (Schedule)
-              Schedule->Dump(f, "215-", DumpMode, AtTime);
-           else
-              Schedules->Dump(f, "215-", DumpMode, AtTime);
-           fflush(f);
-           Reply(215, "End of EPG data");
-           fclose(f);
-           }
-        else {
-           Reply(451, "Can't open file connection");
-           close(fd);
-           }
+     if (!Schedule)
+        return true; // all schedules are sent one by one by SendEpg()
+     FILE *f = open_memstream(Buffer, Size);
+     if (f) {
+        Schedule->Dump(f, "215-", DumpMode, AtTime);
+        fclose(f);
+        return true;
         }
-     else
-        Reply(451, "Can't dup stream descriptor");
+     Reply(451, "Can't allocate EPG buffer");
+     }
+  else
+     Reply(451, "Can't get EPG data");
+  return false;
+}
+
+bool cSVDRP::FindEpg(const char *Option, char **Buffer, size_t *Size)
+{
+  cSchedulesLock SchedulesLock;
+  const cSchedules *Schedules = cSchedules::Schedules(SchedulesLock);
+  if (Schedules) {
+     cVector<const cEvent *> Events;
+     Schedules->Search(Option, Events);
+     FILE *f = open_memstream(Buffer, Size);
+     if (f) {
+        time_t Outdated = time(NULL) - Setup.EPGLinger * 60;
+        const cSchedule *Schedule = NULL;
+        int Found = 0;
+        for (int i = 0; i < Events.Size(); i++) {
+            const cEvent *Event = Events[i];
+            if (Event->EndTime() < Outdated)
+               continue;
+            if (Event->Schedule() != Schedule) {
+               cChannel *Channel = Channels.GetByChannelID(Event->Schedule()->ChannelID(), true);
+               if (!Channel)
+                  continue;
+               if (Schedule)
+                  fprintf(f, "215-c\n");
+               Schedule = Event->Schedule();
+               fprintf(f, "215-C %s %s\n", *Channel->GetChannelID().ToString(), Channel->Name());
+               }
+            Event->Dump(f, "215-");
+            Found++;
+            }
+        if (Schedule)
+           fprintf(f, "215-c\n");
+        fclose(f);
+        if (Found)
+           return true;
+        free(*Buffer);
+        Reply(550, "No matching events found");
+        return false;
+        }
+     Reply(451, "Can't allocate EPG buffer");
      }
   else
      Reply(451, "Can't get EPG data");
+  return false;
+}
+
+void cSVDRP::SendEpg(char *Buffer, size_t Size, eDumpMode DumpMode, time_t AtTime)
+{
+  int fd = dup(file);
+  if (fd) {
+     FILE *f = fdopen(fd, "w");
+     if (f) {
+        if (Buffer)
+           fwrite(Buffer, 1, Size, f);
+        else
+           cSchedules::Dump(f, "215-", DumpMode, AtTime);
+        fflush(f);
+        Reply(215, "End of EPG data");
+        fclose(f);
+        }
+     else {
+        Reply(451, "Can't open file connection");
+        close(fd);
+        }
+     }
+  else
+     Reply(451, "Can't dup stream descriptor");
+  free(Buffer);
+}
+
+void cSVDRP::CmdLSTE(const char *Option)
+{
+  // The EPG data is copied while holding the schedules lock and sent after
+  // releasing it, so that a slow client doesn't hold up the EIT filters.
+  // Without a channel, this is done one schedule at a time:
+  char *Buffer = NULL;
+  size_t Size = 0;
+  eDumpMode DumpMode;
+  time_t AtTime;
+  if (DumpEpg(Option, &Buffer, &Size, DumpMode, AtTime))
+     SendEpg(Buffer, Size, DumpMode, AtTime);
 }
 
 void cSVDRP::CmdLSTR(const char *Option)
@@ -1472,14 +1584,62 @@ void cSVDRP::CmdSCAN(const char *Option)
   Reply(250, "EPG scan triggered");
 }
 
+static const char *StatOption(const char *Option, const char *Name)
+{
+  int l = strlen(Name);
+  if (strncasecmp(Option, Name, l) == 0 && (!Option[l] || isspace(Option[l])))
+     return skipspace(Option + l);
+  return NULL;
+}
+
 void cSVDRP::CmdSTAT(const char *Option)
 {
   if (*Option) {
+     const char *o;
+     char What = 0;
+     if ((o = StatOption(Option, "REPLAY")) != NULL)
+        What = 'R';
+     else if ((o = StatOption(Option, "SECTIONS")) != NULL)
+        What = 'E';
+     else if ((o = StatOption(Option, "SWITCH")) != NULL)
+        What = 'S';
+     else if ((o = StatOption(Option, "TRANSFER")) != NULL)
+        What = 'T';
      if (strcasecmp(Option, "DISK") == 0) {
         int FreeMB, UsedMB;
         int Percent = VideoDiskSpace(&FreeMB, &UsedMB);
         Reply(250, "%dMB %dMB %d%%", FreeMB + UsedMB, FreeMB, Percent);
         }
+     else if (What) {
+        if (!*o) {
+           char *s = strdup(What == 'R' ? cDvbPlayerControl::Statistics() : What == 'E' ? cDevice::SectionStatistics() : What == 'S' ? cZapTrace::Statistics() : cTransferControl::Statistics());
+           char *strtok_next;
+           char *p = strtok_r(s, "\n", &strtok_next);
+           while (p) {
+                 char *q = strtok_r(NULL, "\n", &strtok_next);
+                 Reply(q ? -250 : 250, "%s", p);
+                 p = q;
+                 }
+           free(s);
+           }
+        else if (strcasecmp(o, "CLEAR") == 0) {
+           switch (What) {
+             case 'R': cDvbPlayerControl::ClearStatistics();
+                       Reply(250, "Replay statistics cleared");
+                       break;
+             case 'E': cDevice::ClearSectionStatistics();
+                       Reply(250, "Section statistics cleared");
+                       break;
+             case 'S': cZapTrace::ClearStatistics();
+                       Reply(250, "Channel switch statistics cleared");
+                       break;
+             case 'T': cTransferControl::ClearStatistics();
+                       Reply(250, "Transfer statistics cleared");
+             }
+           }
+        else
+           Reply(501, "Invalid Option \"%s\"", Option);
+        }
      else
         Reply(501, "Invalid Option \"%s\"", Option);
      }
@@ -1568,6 +1728,7 @@ void cSVDRP::Execute(char *Cmd)
   else if (CMD("DELR"))  CmdDELR(s);
   else if (CMD("DELT"))  CmdDELT(s);
   else if (CMD("EDIT"))  CmdEDIT(s);
+  else if (CMD("FNDE"))  CmdFNDE(s);
   else if (CMD("GRAB"))  CmdGRAB(s);
   else if (CMD("HELP"))  CmdHELP(s);
   else if (CMD("HITK"))  CmdHITK(s);
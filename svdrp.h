@@ -54,12 +54,16 @@ private:
   bool Send(const char *s, int length = -1);
   void Reply(int Code, const char *fmt, ...) __attribute__ ((format (printf, 3, 4)));
   void PrintHelpTopics(const char **hp);
+  bool DumpEpg(const char *Option, char **Buffer, size_t *Size, eDumpMode &DumpMode, time_t &AtTime);
+  bool FindEpg(const char *Option, char **Buffer, size_t *Size);
+  void SendEpg(char *Buffer, size_t Size, eDumpMode DumpMode = dmAll, time_t AtTime = 0);
   void CmdCHAN(const char *Option);
   void CmdCLRE(const char *Option);
   void CmdDELC(const char *Option);
   void CmdDELR(const char *Option);
   void CmdDELT(const char *Option);
   void CmdEDIT(const char *Option);
+  void CmdFNDE(const char *Option);
   void CmdGRAB(const char *Option);
   void CmdHELP(const char *Option);
   void CmdHITK(const char *Option);
@@ -87,6 +87,7 @@ private:
   static void *StartThread(cThread *Thread);
 protected:
   void SetPriority(int Priority);
+  void SetIOPriority(int Priority);
   void Lock(void) { mutex.Lock(); }
   void Unlock(void) { mutex.Unlock(); }
   virtual void Action(void) = 0;
@@ -0,0 +1,643 @@
+/*
+ * timeshift.c: Pausing live video in memory
+ *
+ * See the main source file 'vdr.c' for copyright information and
+ * how to reach the author.
+ *
+ * $Id$
+ */
+
+#include "timeshift.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "device.h"
+#include "recording.h"
+#include "videodir.h"
+
+#define TIMESHIFTBUFSIZE   MEGABYTE(2) // the buffer for the incoming TS data
+#define TIMESHIFTFRAMESIZE KILOBYTE(1) // an assumption about the minimum average frame size
+#define TIMESHIFTFILE      ".timeshift"
+#define MODETIMEOUT        3 // seconds
+
+// --- cTimeShiftBuffer ------------------------------------------------------
+
+cTimeShiftBuffer::cTimeShiftBuffer(int Size, const char *FileName)
+{
+  size = Size;
+  data = NULL;
+  mapped = false;
+  maxFrames = size / TIMESHIFTFRAMESIZE + 2;
+  frames = MALLOC(tFrame, maxFrames);
+  first = next = 0;
+  begin = end = 0;
+  if (FileName) {
+     int f = open(FileName, O_RDWR | O_CREAT | O_TRUNC, DEFFILEMODE);
+     if (f >= 0) {
+        unlink(FileName); // the file disappears as soon as the buffer is deleted
+        if (ftruncate(f, size) == 0) {
+           void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, f, 0);
+           if (p != MAP_FAILED) {
+              data = (uchar *)p;
+              mapped = true;
+              }
+           else
+              LOG_ERROR_STR(FileName);
+           }
+        else
+           LOG_ERROR_STR(FileName);
+        close(f);
+        }
+     else
+        LOG_ERROR_STR(FileName);
+     }
+  if (!data)
+     data = MALLOC(uchar, size);
+  if (!Ok())
+     esyslog("ERROR: can't allocate time shift buffer");
+}
+
+cTimeShiftBuffer::~cTimeShiftBuffer()
+{
+  if (mapped)
+     munmap(data, size);
+  else
+     free(data);
+  free(frames);
+}
+
+void cTimeShiftBuffer::Copy(int64_t Offset, uchar *Buffer, int Length)
+{
+  while (Length > 0) {
+        int o = Offset % size;
+        int n = min(Length, size - o);
+        memcpy(Buffer, data + o, n);
+        Buffer += n;
+        Offset += n;
+        Length -= n;
+        }
+}
+
+void cTimeShiftBuffer::Put(const uchar *Data, int Count, uchar PictureType)
+{
+  cMutexLock MutexLock(&mutex);
+  if (!Ok())
+     return;
+  if (PictureType == NO_PICTURE) {
+     if (first == next)
+        return; // data before the first frame
+     }
+  else {
+     if (first == next && PictureType != I_FRAME)
+        return; // the buffer always starts with an I-frame
+     if (next - first >= maxFrames) {
+        first++;
+        begin = frames[first % maxFrames].offset;
+        }
+     frames[next % maxFrames].offset = end;
+     frames[next % maxFrames].type = PictureType;
+     next++;
+     }
+  // Drop the oldest frames to make room for the new data:
+  while (end + Count - begin > size) {
+        if (++first >= next) {
+           // a single frame that doesn't fit into the buffer
+           first = next;
+           begin = end;
+           return;
+           }
+        begin = frames[first % maxFrames].offset;
+        }
+  while (Count > 0) {
+        int o = end % size;
+        int n = min(Count, size - o);
+        memcpy(data + o, Data, n);
+        Data += n;
+        Count -= n;
+        end += n;
+        }
+}
+
+int cTimeShiftBuffer::First(void)
+{
+  cMutexLock MutexLock(&mutex);
+  return first;
+}
+
+int cTimeShiftBuffer::Last(void)
+{
+  cMutexLock MutexLock(&mutex);
+  return next > first ? next - 2 : first - 1; // the frame at 'next - 1' is still being written
+}
+
+int cTimeShiftBuffer::Read(int Index, uchar *Buffer, int Max, uchar *PictureType)
+{
+  cMutexLock MutexLock(&mutex);
+  if (Index < first || Index > next - 2)
+     return -1;
+  int64_t Offset = frames[Index % maxFrames].offset;
+  int Length = frames[(Index + 1) % maxFrames].offset - Offset;
+  if (Length > Max) {
+     esyslog("ERROR: frame larger than buffer (%d > %d)", Length, Max);
+     Length = Max;
+     }
+  Copy(Offset, Buffer, Length);
+  if (PictureType)
+     *PictureType = frames[Index % maxFrames].type;
+  return Length;
+}
+
+int cTimeShiftBuffer::GetNextIFrame(int Index, bool Forward)
+{
+  cMutexLock MutexLock(&mutex);
+  int Last = next - 2;
+  if (Forward)
+     Index = max(Index, first - 1);
+  else
+     Index = min(Index, Last + 1);
+  int d = Forward ? 1 : -1;
+  for (Index += d; first <= Index && Index <= Last; Index += d) {
+      if (frames[Index % maxFrames].type == I_FRAME)
+         return Index;
+      }
+  return -1;
+}
+
+// --- cTimeShiftRecorder ----------------------------------------------------
+
+cTimeShiftRecorder::cTimeShiftRecorder(cTimeShiftBuffer *Buffer, const cChannel *Channel, int Priority)
+:cReceiver(Channel->GetChannelID(), Priority, Channel->Vpid(), Channel->Apids(), Setup.UseDolbyDigital ? Channel->Dpids() : NULL, Channel->Spids())
+,cThread("time shift")
+{
+  buffer = Buffer;
+  ringBuffer = new cRingBufferLinear(TIMESHIFTBUFSIZE, TS_SIZE * 2, true, "Time shift");
+  ringBuffer->SetTimeouts(0, 100);
+  remux = new cRemux(Channel->Vpid(), Channel->Apids(), Setup.UseDolbyDigital ? Channel->Dpids() : NULL, Channel->Spids());
+}
+
+cTimeShiftRecorder::~cTimeShiftRecorder()
+{
+  Detach();
+  delete remux;
+  delete ringBuffer;
+}
+
+void cTimeShiftRecorder::Activate(bool On)
+{
+  if (On)
+     Start();
+  else
+     Cancel(3);
+}
+
+void cTimeShiftRecorder::Receive(uchar *Data, int Length)
+{
+  if (Running()) {
+     int p = ringBuffer->Put(Data, Length);
+     if (p != Length && Running())
+        ringBuffer->ReportOverflow(Length - p);
+     }
+}
+
+void cTimeShiftRecorder::Action(void)
+{
+  while (Running()) {
+        int r;
+        uchar *b = ringBuffer->Get(r);
+        if (b) {
+           int Count = remux->Put(b, r);
+           if (Count)
+              ringBuffer->Del(Count);
+           }
+        int Count;
+        uchar PictureType;
+        uchar *p;
+        while ((p = remux->Get(Count, &PictureType)) != NULL) {
+              buffer->Put(p, Count, PictureType);
+              remux->Del(Count);
+              }
+        }
+}
+
+// --- cTimeShiftPlayer ------------------------------------------------------
+
+class cTimeShiftPlayer : public cPlayer, cThread {
+private:
+  enum ePlayModes { pmPlay, pmPause, pmFast, pmStill };
+  cTimeShiftBuffer *buffer;
+  ePlayModes playMode;
+  bool forward;
+  bool firstPacket;
+  int readIndex;
+  uchar *frame;
+  uchar *p;
+  int pc;
+  void Empty(void);
+  bool NextFrame(void);
+protected:
+  virtual void Activate(bool On);
+  virtual void Action(void);
+public:
+  cTimeShiftPlayer(cTimeShiftBuffer *Buffer);
+  virtual ~cTimeShiftPlayer();
+  bool Active(void) { return cThread::Running(); }
+  void Pause(void);
+  void Play(void);
+  void Forward(void);
+  void Backward(void);
+  void SkipSeconds(int Seconds);
+  virtual bool GetIndex(int &Current, int &Total, bool SnapToIFrame = false);
+  virtual bool GetReplayMode(bool &Play, bool &Forward, int &Speed);
+  };
+
+cTimeShiftPlayer::cTimeShiftPlayer(cTimeShiftBuffer *Buffer)
+:cThread("time shift player")
+{
+  buffer = Buffer;
+  playMode = pmStill; // until the first I-frame has been shown
+  forward = true;
+  firstPacket = true;
+  readIndex = -1;
+  frame = MALLOC(uchar, MAXFRAMESIZE);
+  p = NULL;
+  pc = 0;
+}
+
+cTimeShiftPlayer::~cTimeShiftPlayer()
+{
+  Detach();
+  free(frame);
+}
+
+void cTimeShiftPlayer::Activate(bool On)
+{
+  if (On)
+     Start();
+  else
+     Cancel(9);
+}
+
+void cTimeShiftPlayer::Empty(void)
+{
+  LOCK_THREAD;
+  p = NULL;
+  pc = 0;
+  DeviceClear();
+  firstPacket = true;
+}
+
+bool cTimeShiftPlayer::NextFrame(void)
+{
+  int Index;
+  if (playMode == pmFast) {
+     Index = buffer->GetNextIFrame(readIndex, forward);
+     if (Index < 0) {
+        // hit the live end or the beginning of the buffer:
+        if (!DeviceFlush(100))
+           return false;
+        DevicePlay();
+        playMode = pmPlay;
+        forward = true;
+        return false;
+        }
+     }
+  else {
+     Index = readIndex + 1;
+     if (Index < buffer->First()) {
+        // the frames we were about to play have been dropped:
+        Index = buffer->GetNextIFrame(buffer->First() - 1, true);
+        firstPacket = true;
+        }
+     }
+  int Length = Index >= 0 ? buffer->Read(Index, frame, MAXFRAMESIZE) : -1;
+  if (Length > 0) {
+     readIndex = Index;
+     p = frame;
+     pc = Length;
+     if (firstPacket) {
+        PlayPes(NULL, 0);
+        cRemux::SetBrokenLink(p, pc);
+        firstPacket = false;
+        }
+     return true;
+     }
+  return false;
+}
+
+void cTimeShiftPlayer::Action(void)
+{
+  while (Running()) {
+        bool Sleep = false;
+        cPoller Poller;
+        if (DevicePoll(Poller, 100)) {
+           LOCK_THREAD;
+           if (playMode == pmStill && readIndex < 0) {
+              // show the first I-frame as soon as it is available:
+              int Index = buffer->GetNextIFrame(-1, true);
+              int Length = Index >= 0 ? buffer->Read(Index, frame, MAXFRAMESIZE) : -1;
+              if (Length > 0) {
+                 DeviceStillPicture(frame, Length);
+                 readIndex = Index;
+                 }
+              else
+                 Sleep = true;
+              }
+           else if (!pc && (playMode == pmPlay || playMode == pmFast))
+              Sleep = !NextFrame();
+           if (pc) {
+              int w = PlayPes(p, pc, playMode != pmPlay);
+              if (w > 0) {
+                 p += w;
+                 pc -= w;
+                 }
+              else if (w < 0 && FATALERRNO) {
+                 LOG_ERROR;
+                 break;
+                 }
+              }
+           else
+              Sleep = true;
+           }
+        if (Sleep)
+           cCondWait::SleepMs(3); // this keeps the CPU load low
+        }
+}
+
+void cTimeShiftPlayer::Pause(void)
+{
+  if (playMode == pmPause || playMode == pmStill)
+     Play();
+  else {
+     LOCK_THREAD;
+     if (playMode == pmFast)
+        Empty();
+     DeviceFreeze();
+     playMode = pmPause;
+     }
+}
+
+void cTimeShiftPlayer::Play(void)
+{
+  if (playMode != pmPlay) {
+     LOCK_THREAD;
+     if (playMode == pmStill || playMode == pmFast)
+        Empty();
+     DevicePlay();
+     playMode = pmPlay;
+     forward = true;
+     }
+}
+
+void cTimeShiftPlayer::Forward(void)
+{
+  if (playMode == pmFast && forward)
+     Play();
+  else {
+     LOCK_THREAD;
+     Empty();
+     DeviceMute();
+     playMode = pmFast;
+     forward = true;
+     DeviceTrickSpeed(1);
+     }
+}
+
+void cTimeShiftPlayer::Backward(void)
+{
+  if (playMode == pmFast && !forward)
+     Play();
+  else {
+     LOCK_THREAD;
+     Empty();
+     DeviceMute();
+     playMode = pmFast;
+     forward = false;
+     DeviceTrickSpeed(1);
+     }
+}
+
+void cTimeShiftPlayer::SkipSeconds(int Seconds)
+{
+  if (Seconds) {
+     LOCK_THREAD;
+     Empty();
+     int Index = readIndex + Seconds * FRAMESPERSEC;
+     Index = max(min(Index, buffer->Last()), buffer->First());
+     int i = buffer->GetNextIFrame(Index + 1, false);
+     if (i < 0)
+        i = buffer->GetNextIFrame(Index, true);
+     if (i >= 0)
+        readIndex = i - 1; // Action() will first increment it!
+     if (playMode == pmStill) // the first I-frame has not yet been shown
+        playMode = pmPause;
+     Play();
+     }
+}
+
+bool cTimeShiftPlayer::GetIndex(int &Current, int &Total, bool SnapToIFrame)
+{
+  int First = buffer->First();
+  Current = max(readIndex - First, 0);
+  Total = buffer->Last() - First + 1;
+  return true;
+}
+
+bool cTimeShiftPlayer::GetReplayMode(bool &Play, bool &Forward, int &Speed)
+{
+  Play = (playMode == pmPlay || playMode == pmFast);
+  Forward = forward;
+  Speed = playMode == pmFast ? 0 : -1;
+  return true;
+}
+
+// --- cTimeShiftControl -----------------------------------------------------
+
+cTimeShiftControl::cTimeShiftControl(cTimeShiftBuffer *Buffer, cTimeShiftRecorder *Recorder, const cChannel *Channel)
+:cControl(player = new cTimeShiftPlayer(Buffer))
+{
+  buffer = Buffer;
+  recorder = Recorder;
+  displayReplay = NULL;
+  title = strdup(Channel->Name());
+  visible = modeOnly = false;
+  lastCurrent = lastTotal = -1;
+  lastPlay = lastForward = false;
+  lastSpeed = -2; // an invalid value
+  timeoutShow = 0;
+}
+
+cTimeShiftControl::~cTimeShiftControl()
+{
+  Hide();
+  delete player;
+  delete recorder;
+  delete buffer;
+  free(title);
+}
+
+bool cTimeShiftControl::Start(void)
+{
+  cChannel *Channel = Channels.GetByNumber(cDevice::CurrentChannel());
+  if (!Channel)
+     return false;
+  cDevice *Device = cDevice::GetDevice(Channel, Setup.PausePriority, false);
+  if (!Device)
+     return false;
+  dsyslog("switching device %d to channel %d", Device->DeviceNumber() + 1, Channel->Number());
+  if (!Device->SwitchChannel(Channel, false))
+     return false;
+  cString FileName = Setup.TimeShiftFile ? *AddDirectory(VideoDirectory, TIMESHIFTFILE) : NULL;
+  cTimeShiftBuffer *Buffer = new cTimeShiftBuffer(MEGABYTE(Setup.TimeShiftSize), FileName);
+  if (Buffer->Ok()) {
+     cTimeShiftRecorder *Recorder = new cTimeShiftRecorder(Buffer, Channel, Setup.PausePriority);
+     if (Device->AttachReceiver(Recorder)) {
+        isyslog("pausing live video of channel %d in a %d MB time shift buffer", Channel->Number(), Setup.TimeShiftSize);
+        cControl::Launch(new cTimeShiftControl(Buffer, Recorder, Channel));
+        cControl::Attach();
+        return true;
+        }
+     delete Recorder;
+     }
+  delete Buffer;
+  return false;
+}
+
+void cTimeShiftControl::Show(void)
+{
+  if (modeOnly)
+     Hide();
+  if (!visible)
+     ShowProgress(true);
+}
+
+void cTimeShiftControl::Hide(void)
+{
+  if (visible) {
+     delete displayReplay;
+     displayReplay = NULL;
+     SetNeedsFastResponse(false);
+     visible = false;
+     modeOnly = false;
+     lastPlay = lastForward = false;
+     lastSpeed = -2; // an invalid value
+     }
+}
+
+void cTimeShiftControl::ShowMode(void)
+{
+  if (visible || Setup.ShowReplayMode && !cOsd::IsOpen()) {
+     bool Play, Forward;
+     int Speed;
+     if (GetReplayMode(Play, Forward, Speed) && (!visible || Play != lastPlay || Forward != lastForward || Speed != lastSpeed)) {
+        bool NormalPlay = (Play && Speed == -1);
+
+        if (!visible) {
+           if (NormalPlay)
+              return; // no need to do indicate ">" unless there was a different mode displayed before
+           visible = modeOnly = true;
+           displayReplay = Skins.Current()->DisplayReplay(modeOnly);
+           }
+
+        if (modeOnly && !timeoutShow && NormalPlay)
+           timeoutShow = time(NULL) + MODETIMEOUT;
+        displayReplay->SetMode(Play, Forward, Speed);
+        lastPlay = Play;
+        lastForward = Forward;
+        lastSpeed = Speed;
+        }
+     }
+}
+
+bool cTimeShiftControl::ShowProgress(bool Initial)
+{
+  int Current, Total;
+
+  if (GetIndex(Current, Total) && Total > 0) {
+     if (!visible) {
+        displayReplay = Skins.Current()->DisplayReplay(modeOnly);
+        SetNeedsFastResponse(true);
+        visible = true;
+        }
+     if (Initial) {
+        displayReplay->SetTitle(title);
+        lastCurrent = lastTotal = -1;
+        }
+     if (Total != lastTotal) {
+        displayReplay->SetTotal(IndexToHMSF(Total));
+        if (!Initial)
+           displayReplay->Flush();
+        }
+     if (Current != lastCurrent || Total != lastTotal) {
+        displayReplay->SetProgress(Current, Total);
+        if (!Initial)
+           displayReplay->Flush();
+        displayReplay->SetCurrent(IndexToHMSF(Current));
+        displayReplay->Flush();
+        lastCurrent = Current;
+        }
+     lastTotal = Total;
+     ShowMode();
+     return true;
+     }
+  return false;
+}
+
+eOSState cTimeShiftControl::ProcessKey(eKeys Key)
+{
+  if (!player->Active())
+     return osEnd;
+  if (visible) {
+     if (timeoutShow && time(NULL) > timeoutShow) {
+        Hide();
+        ShowMode();
+        timeoutShow = 0;
+        }
+     else if (modeOnly)
+        ShowMode();
+     else
+        ShowProgress(false);
+     }
+  bool DoShowMode = true;
+  switch (Key) {
+    // Positioning:
+    case kPlay:
+    case kUp:      player->Play(); break;
+    case kPause:
+    case kDown:    player->Pause(); break;
+    case kFastRew|k_Release:
+    case kLeft|k_Release:
+                   if (Setup.MultiSpeedMode) break;
+    case kFastRew:
+    case kLeft:    player->Backward(); break;
+    case kFastFwd|k_Release:
+    case kRight|k_Release:
+                   if (Setup.MultiSpeedMode) break;
+    case kFastFwd:
+    case kRight:   player->Forward(); break;
+    case kGreen|k_Repeat:
+    case kGreen:   player->SkipSeconds(-60); break;
+    case kYellow|k_Repeat:
+    case kYellow:  player->SkipSeconds( 60); break;
+    case kStop:
+    case kBlue:
+    case kBack:    Hide();
+                   return osEnd; // back to live video
+    default: {
+      DoShowMode = false;
+      switch (Key) {
+        // Menu control:
+        case kOk:      if (visible && !modeOnly) {
+                          Hide();
+                          DoShowMode = true;
+                          }
+                       else
+                          Show();
+                       break;
+        default:       return osUnknown;
+        }
+      }
+    }
+  if (DoShowMode)
+     ShowMode();
+  return osContinue;
+}
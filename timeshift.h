@@ -0,0 +1,107 @@
+/*
+ * timeshift.h: Pausing live video in memory
+ *
+ * See the main source file 'vdr.c' for copyright information and
+ * how to reach the author.
+ *
+ * $Id$
+ */
+
+#ifndef __TIMESHIFT_H
+#define __TIMESHIFT_H
+
+#include "channels.h"
+#include "player.h"
+#include "receiver.h"
+#include "remux.h"
+#include "ringbuffer.h"
+#include "skins.h"
+#include "thread.h"
+
+#define MAXTIMESHIFTSIZE 1024 // MB
+
+/// The cTimeShiftBuffer holds the most recent frames of a live stream in
+/// memory, together with an index of these frames. If the buffer is full,
+/// the oldest frames are dropped.
+
+class cTimeShiftBuffer {
+private:
+  struct tFrame { int64_t offset; uchar type; };
+  cMutex mutex;
+  uchar *data;
+  int size;
+  bool mapped;
+  tFrame *frames;
+  int maxFrames;
+  int first, next;
+  int64_t begin, end;
+  void Copy(int64_t Offset, uchar *Buffer, int Length);
+public:
+  cTimeShiftBuffer(int Size, const char *FileName = NULL);
+       ///< Creates a buffer of Size bytes. If FileName is given, the buffer is
+       ///< backed by that file, so that the kernel may move parts of it to the
+       ///< disk instead of keeping all of it in memory.
+  ~cTimeShiftBuffer();
+  bool Ok(void) { return data && frames; }
+  void Put(const uchar *Data, int Count, uchar PictureType);
+       ///< Appends Count bytes of Data to the buffer. A PictureType other than
+       ///< NO_PICTURE starts a new frame.
+  int First(void);
+       ///< Returns the number of the oldest frame in the buffer.
+  int Last(void);
+       ///< Returns the number of the newest complete frame in the buffer
+       ///< (First() - 1 if there is none).
+  int Read(int Index, uchar *Buffer, int Max, uchar *PictureType = NULL);
+       ///< Copies the frame with the given Index into Buffer (at most Max bytes)
+       ///< and returns its length. Returns -1 if the frame is not (or no longer)
+       ///< in the buffer.
+  int GetNextIFrame(int Index, bool Forward);
+       ///< Returns the number of the next I-frame after (or before) Index, or -1
+       ///< if there is none.
+  };
+
+class cTimeShiftRecorder : public cReceiver, cThread {
+private:
+  cRingBufferLinear *ringBuffer;
+  cRemux *remux;
+  cTimeShiftBuffer *buffer;
+protected:
+  virtual void Activate(bool On);
+  virtual void Receive(uchar *Data, int Length);
+  virtual void Action(void);
+public:
+  cTimeShiftRecorder(cTimeShiftBuffer *Buffer, const cChannel *Channel, int Priority);
+       ///< Creates a receiver that stores the given Channel in Buffer.
+  virtual ~cTimeShiftRecorder();
+  };
+
+class cTimeShiftPlayer;
+
+class cTimeShiftControl : public cControl {
+private:
+  cTimeShiftBuffer *buffer;
+  cTimeShiftRecorder *recorder;
+  cTimeShiftPlayer *player;
+  cSkinDisplayReplay *displayReplay;
+  char *title;
+  bool visible, modeOnly;
+  int lastCurrent, lastTotal;
+  bool lastPlay, lastForward;
+  int lastSpeed;
+  time_t timeoutShow;
+  void ShowMode(void);
+  bool ShowProgress(bool Initial);
+  cTimeShiftControl(cTimeShiftBuffer *Buffer, cTimeShiftRecorder *Recorder, const cChannel *Channel);
+public:
+  virtual ~cTimeShiftControl();
+  virtual eOSState ProcessKey(eKeys Key);
+  virtual void Show(void);
+  virtual void Hide(void);
+  static bool Start(void);
+       ///< Pauses the current live channel by storing it in a time shift buffer
+       ///< of Setup.TimeShiftSize MB and launches a control for replaying it.
+       ///< Returns false if this is not possible (for instance because there is
+       ///< no free device).
+  };
+
+#endif //__TIMESHIFT_H
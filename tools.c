@@ -18,8 +18,12 @@ extern "C" {
 #include <jpeglib.h>
 #undef boolean
 }
+#include <limits.h>
+#include <linux/fs.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
 #include <sys/time.h>
 #include <sys/vfs.h>
 #include <time.h>
@@ -605,6 +609,94 @@ uint64_t cTimeMs::Elapsed(void)
   return Now() - begin;
 }
 
+// --- cHistogram ------------------------------------------------------------
+
+const int cHistogram::limits[HISTOGRAMBUCKETS] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, INT_MAX };
+
+cHistogram::cHistogram(int Window)
+{
+  window = max(Window, 0);
+  values = NULL;
+  Clear();
+}
+
+cHistogram::~cHistogram()
+{
+  free(values);
+}
+
+int cHistogram::Bucket(int Ms)
+{
+  int i = 0;
+  while (Ms > limits[i])
+        i++;
+  return i;
+}
+
+void cHistogram::Clear(void)
+{
+  memset(buckets, 0, sizeof(buckets));
+  count = maximum = 0;
+  sum = 0;
+  next = 0;
+}
+
+void cHistogram::Add(int Ms)
+{
+  if (Ms < 0)
+     Ms = 0;
+  bool DroppedMaximum = false;
+  if (window) {
+     if (!values && (values = MALLOC(int, window)) == NULL)
+        return;
+     if (count == window) {
+        int Oldest = values[next];
+        buckets[Bucket(Oldest)]--;
+        count--;
+        sum -= Oldest;
+        DroppedMaximum = Oldest == maximum;
+        }
+     values[next] = Ms;
+     next = (next + 1) % window;
+     }
+  buckets[Bucket(Ms)]++;
+  count++;
+  sum += Ms;
+  if (DroppedMaximum) {
+     maximum = 0;
+     for (int i = 0; i < count; i++)
+         maximum = max(maximum, values[i]);
+     }
+  else if (Ms > maximum)
+     maximum = Ms;
+}
+
+int cHistogram::Percentile(int Percent) const
+{
+  int n = (count * Percent + 99) / 100;
+  for (int i = 0; i < HISTOGRAMBUCKETS; i++) {
+      n -= buckets[i];
+      if (n <= 0)
+         return min(limits[i], maximum);
+      }
+  return maximum;
+}
+
+cString cHistogram::ToString(void) const
+{
+  char buffer[512];
+  int l = snprintf(buffer, sizeof(buffer), "count=%d avg=%d p50=%d p90=%d p99=%d max=%d", count, count ? int(sum / count) : 0, Percentile(50), Percentile(90), Percentile(99), maximum);
+  for (int i = 0; i < HISTOGRAMBUCKETS && l < int(sizeof(buffer)); i++) {
+      if (buckets[i]) {
+         if (limits[i] < INT_MAX)
+            l += snprintf(buffer + l, sizeof(buffer) - l, " %d:%d", limits[i], buckets[i]);
+         else
+            l += snprintf(buffer + l, sizeof(buffer) - l, " more:%d", buckets[i]);
+         }
+      }
+  return buffer;
+}
+
 // --- UTF-8 support ---------------------------------------------------------
 
 static uint SystemToUtf8[128] = { 0 };
@@ -1620,6 +1712,102 @@ ssize_t cUnbufferedFile::Write(const void *Data, size_t Size)
   return -1;
 }
 
+#define COPY_BUFFER MEGABYTE(1)
+
+ssize_t cUnbufferedFile::CopyFrom(cUnbufferedFile *File, off_t Offset, size_t Size)
+{
+  if (fd >= 0 && File->fd >= 0) {
+     off_t start = curpos;
+     size_t copied = 0;
+#ifdef __NR_copy_file_range
+     static bool CopyFileRangeSupported = true;
+     while (CopyFileRangeSupported && copied < Size) {
+           loff_t off = Offset + copied;
+           ssize_t r = syscall(__NR_copy_file_range, File->fd, &off, fd, NULL, Size - copied, 0);
+           if (r > 0)
+              copied += r;
+           else if (r < 0 && errno == EINTR)
+              continue;
+           else {
+              if (r < 0) {
+                 if (errno == ENOSYS)
+                    CopyFileRangeSupported = false;
+                 else if (errno != EXDEV && errno != EINVAL && errno != EOPNOTSUPP)
+                    return -1;
+                 }
+              break; // let's try it the old fashioned way
+              }
+           }
+#endif
+     if (copied < Size) {
+        uchar *buffer = MALLOC(uchar, COPY_BUFFER);
+        if (!buffer)
+           return -1;
+        while (copied < Size) {
+              ssize_t r = pread(File->fd, buffer, min(Size - copied, size_t(COPY_BUFFER)), Offset + copied);
+              if (r < 0 && errno == EINTR)
+                 continue;
+              if (r <= 0 || safe_write(fd, buffer, r) != r)
+                 break;
+              copied += r;
+              }
+        free(buffer);
+        }
+     curpos += copied;
+#ifdef USE_FADVISE
+     // Neither the source nor the copied data are going to be needed again any time soon:
+     File->FadviseDrop(Offset, copied);
+     posix_fadvise(fd, start, copied, POSIX_FADV_DONTNEED);
+     lastpos = begin = curpos;
+#endif
+     return copied;
+     }
+  return -1;
+}
+
+int cUnbufferedFile::CloneBlockSize(cUnbufferedFile *File)
+{
+#ifdef FICLONERANGE
+  struct stat From, To;
+  if (fd >= 0 && File->fd >= 0 && fstat(File->fd, &From) == 0 && fstat(fd, &To) == 0) {
+     if (From.st_dev == To.st_dev && To.st_size == 0 && From.st_size >= To.st_blksize) {
+        // Let's just try it with the first block of File:
+        struct file_clone_range fcr = { File->fd, 0, (__u64)To.st_blksize, 0 };
+        if (ioctl(fd, FICLONERANGE, &fcr) == 0) {
+           if (ftruncate(fd, 0) == 0)
+              return To.st_blksize;
+           LOG_ERROR;
+           }
+        }
+     }
+#endif
+  return 0;
+}
+
+ssize_t cUnbufferedFile::CloneFrom(cUnbufferedFile *File, off_t Offset, size_t Size)
+{
+#ifdef FICLONERANGE
+  struct stat From, To;
+  if (fd >= 0 && File->fd >= 0 && fstat(File->fd, &From) == 0 && fstat(fd, &To) == 0) {
+     // The length of the cloned range must be a multiple of the block size, unless
+     // it extends to the end of File:
+     off_t Length = (Size + To.st_blksize - 1) / To.st_blksize * To.st_blksize;
+     if (Offset + Length > From.st_size)
+        Length = From.st_size - Offset;
+     struct file_clone_range fcr = { File->fd, (__u64)Offset, (__u64)Length, (__u64)curpos };
+     if (Length >= off_t(Size) && ioctl(fd, FICLONERANGE, &fcr) == 0) {
+        if (ftruncate(fd, curpos + Size) == 0) {
+           curpos = lseek(fd, curpos + Size, SEEK_SET);
+           return Size;
+           }
+        LOG_ERROR;
+        return -1;
+        }
+     }
+#endif
+  return CopyFrom(File, Offset, Size);
+}
+
 cUnbufferedFile *cUnbufferedFile::Create(const char *FileName, int Flags, mode_t Mode)
 {
   cUnbufferedFile *File = new cUnbufferedFile;
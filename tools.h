@@ -259,6 +259,38 @@ public:
   uint64_t Elapsed(void);
   };
 
+#define HISTOGRAMBUCKETS 15
+
+class cHistogram {
+private:
+  static const int limits[HISTOGRAMBUCKETS];
+  int buckets[HISTOGRAMBUCKETS];
+  int count;
+  int maximum;
+  uint64_t sum;
+  int window;
+  int *values;
+  int next;
+  static int Bucket(int Ms);
+public:
+  cHistogram(int Window = 0);
+       ///< If Window is given, only the most recent Window values are counted.
+  ~cHistogram();
+  void Clear(void);
+  void Add(int Ms);
+       ///< Adds a value (typically a duration in ms) to this histogram. The values
+       ///< are counted in buckets with limits of 1, 2, 5, 10, 20, 50... ms.
+       ///< If this histogram has a window and it is full, the oldest value is
+       ///< dropped.
+  int Count(void) const { return count; }
+  int Percentile(int Percent) const;
+       ///< Returns the upper limit of the bucket that holds the given percentage
+       ///< of values (or the maximum value, if that is lower).
+  cString ToString(void) const;
+       ///< Returns the number of values, their average, some percentiles and the
+       ///< maximum, followed by the non-empty buckets in the form "limit:count".
+  };
+
 class cReadLine {
 private:
   size_t size;
@@ -352,6 +384,23 @@ public:
   off_t Seek(off_t Offset, int Whence);
   ssize_t Read(void *Data, size_t Size);
   ssize_t Write(const void *Data, size_t Size);
+  ssize_t CopyFrom(cUnbufferedFile *File, off_t Offset, size_t Size);
+       ///< Copies Size bytes, starting at Offset in File, to the current position
+       ///< of this file. If the kernel supports it, the data is copied without
+       ///< passing it through user space. Returns the number of bytes copied, or
+       ///< -1 in case of an error.
+  int CloneBlockSize(cUnbufferedFile *File);
+       ///< Checks whether data from File can be put into this (empty) file by
+       ///< sharing the file system's extents (as on btrfs or XFS), and returns the
+       ///< block size to which the ranges given to CloneFrom() must be aligned.
+       ///< Returns 0 if this is not possible.
+  ssize_t CloneFrom(cUnbufferedFile *File, off_t Offset, size_t Size);
+       ///< Puts the Size bytes starting at Offset in File at the current position
+       ///< of this file, by sharing extents with File. Offset and the current
+       ///< position must be aligned to CloneBlockSize(). Any data following the
+       ///< cloned range in this file is discarded. Falls back to CopyFrom() if
+       ///< extents can't be shared. Returns the number of bytes put into this
+       ///< file, or -1 in case of an error.
   static cUnbufferedFile *Create(const char *FileName, int Flags, mode_t Mode = DEFFILEMODE);
   };
 
@@ -471,7 +520,7 @@ public:
   virtual void Remove(int Index)
   {
     if (Index < size - 1)
-       memmove(&data[Index], &data[Index + 1], (size - Index) * sizeof(T));
+       memmove(&data[Index], &data[Index + 1], (size - Index - 1) * sizeof(T));
     size--;
   }
   virtual void Clear(void)
@@ -8,9 +8,25 @@
  */
 
 #include "transfer.h"
+#include "zaptrace.h"
 
 #define TRANSFERBUFSIZE  MEGABYTE(2)
-#define POLLTIMEOUTS_BEFORE_DEVICECLEAR 6
+#define MINBACKLOG       KILOBYTE(256) // the initial limit for the amount of data waiting in the buffer
+#define MAXBACKLOG       (TRANSFERBUFSIZE * 9 / 10)
+#define BACKLOGTIMEOUT   30000 // ms without overflows before the backlog limit is lowered again
+#define POLLTIMEOUT      10    // ms
+#define DEVICECLEARTIMEOUT 600 // ms the device may refuse to take data before it is cleared
+#define WAITTIMEOUT      100   // ms to wait for new data from the receiver
+
+// --- Transfer statistics ---------------------------------------------------
+
+// The time from a TS packet being read by the receiving device until the
+// PES packet it ended up in has been handed to the output device.
+
+static cMutex TransferStatisticsMutex;
+static cHistogram TransferLatency;
+static int TransferBacklog = MINBACKLOG;
+static int TransferClears = 0;
 
 // --- cTransfer -------------------------------------------------------------
 
@@ -20,6 +36,10 @@ cTransfer::cTransfer(tChannelID ChannelID, int VPid, const int *APids, const int
 {
   ringBuffer = new cRingBufferLinear(TRANSFERBUFSIZE, TS_SIZE * 2, true, "Transfer");
   remux = new cRemux(VPid, APids, Setup.UseDolbyDigital ? DPids : NULL, SPids);
+  firstStamp = numStamps = 0;
+  received = remuxed = 0;
+  waiting = false;
+  maxBacklog = MINBACKLOG;
 }
 
 cTransfer::~cTransfer()
@@ -43,67 +63,141 @@ void cTransfer::Activate(bool On)
 void cTransfer::Receive(uchar *Data, int Length)
 {
   if (cPlayer::IsAttached() && Running()) {
+     uint64_t Time = ReceiveTime();
+     cMutexLock MutexLock(&stampMutex);
      int p = ringBuffer->Put(Data, Length);
      if (p != Length && Running())
         ringBuffer->ReportOverflow(Length - p);
+     if (p > 0) {
+        if (!numStamps || stamps[(firstStamp + numStamps - 1) % TRANSFERSTAMPS].time != Time) {
+           if (numStamps == TRANSFERSTAMPS) {
+              firstStamp = (firstStamp + 1) % TRANSFERSTAMPS;
+              numStamps--;
+              }
+           tStamp *s = &stamps[(firstStamp + numStamps++) % TRANSFERSTAMPS];
+           s->offset = received;
+           s->time = Time;
+           }
+        received += p;
+        if (waiting)
+           newData.Signal();
+        }
      }
 }
 
+void cTransfer::Clear(void)
+{
+  DeviceClear();
+  stampMutex.Lock();
+  ringBuffer->Clear();
+  remuxed = received;
+  numStamps = 0;
+  stampMutex.Unlock();
+  remux->Clear();
+  PlayPes(NULL, 0);
+  cMutexLock MutexLock(&TransferStatisticsMutex);
+  TransferBacklog = maxBacklog;
+  TransferClears++;
+}
+
+uint64_t cTransfer::StampTime(void)
+{
+  // The PES packet the remuxer has just delivered has been completed by the
+  // most recent data we have put into it, so we take the time that data has
+  // been received:
+  cMutexLock MutexLock(&stampMutex);
+  while (numStamps > 1 && stamps[(firstStamp + 1) % TRANSFERSTAMPS].offset < remuxed) {
+        firstStamp = (firstStamp + 1) % TRANSFERSTAMPS;
+        numStamps--;
+        }
+  return numStamps ? stamps[firstStamp].time : 0;
+}
+
 void cTransfer::Action(void)
 {
-  int PollTimeouts = 0;
+  cTimeMs Refused; // how long the device has been refusing to take data
   uchar *p = NULL;
   int Result = 0;
+  uchar PictureType = NO_PICTURE;
+  uint64_t Time = 0;
+  lastClear.Set();
   while (Running()) {
         int Count;
         uchar *b = ringBuffer->Get(Count);
         if (b) {
-           if (ringBuffer->Available() > TRANSFERBUFSIZE * 9 / 10) {
+           if (ringBuffer->Available() > maxBacklog) {
               // If the buffer runs full, we have no chance of ever catching up
               // since the data comes in at the same rate as it goes out (it's "live").
               // So let's clear the buffer instead of suffering from permanent
-              // overflows.
-              dsyslog("clearing transfer buffer to avoid overflows");
-              DeviceClear();
-              ringBuffer->Clear();
-              remux->Clear();
-              PlayPes(NULL, 0);
+              // overflows and an ever increasing delay. If this happens too often,
+              // the input is apparently too bursty for the current limit, so we
+              // allow more data to be buffered.
+              if (lastClear.Elapsed() < BACKLOGTIMEOUT && maxBacklog < MAXBACKLOG)
+                 maxBacklog = min(maxBacklog * 2, MAXBACKLOG);
+              dsyslog("clearing transfer buffer to avoid overflows (backlog limit %d KB)", maxBacklog / KILOBYTE(1));
+              Clear();
+              lastClear.Set();
               p = NULL;
               continue;
               }
            Count = remux->Put(b, Count);
-           if (Count)
+           if (Count) {
               ringBuffer->Del(Count);
+              cMutexLock MutexLock(&stampMutex);
+              remuxed += Count;
+              }
+           }
+        else if (maxBacklog > MINBACKLOG && lastClear.Elapsed() > BACKLOGTIMEOUT) {
+           maxBacklog = max(maxBacklog / 2, MINBACKLOG);
+           lastClear.Set();
+           cMutexLock MutexLock(&TransferStatisticsMutex);
+           TransferBacklog = maxBacklog;
+           }
+        if (!p) {
+           p = remux->Get(Result, &PictureType);
+           if (p) {
+              Time = StampTime();
+              Refused.Set();
+              }
            }
-        if (!p)
-           p = remux->Get(Result);
         if (p) {
            cPoller Poller;
-           if (DevicePoll(Poller, 100)) {
-              PollTimeouts = 0;
+           if (DevicePoll(Poller, POLLTIMEOUT)) {
+              Refused.Set();
               int w = PlayPes(p, Result);
               if (w > 0) {
                  p += w;
                  Result -= w;
                  remux->Del(w);
-                 if (Result <= 0)
+                 if (Result <= 0) {
                     p = NULL;
+                    if (PictureType == I_FRAME)
+                       cZapTrace::Mark(zpIFrame);
+                    if (Time) {
+                       cMutexLock MutexLock(&TransferStatisticsMutex);
+                       TransferLatency.Add(int(cTimeMs::Now() - Time));
+                       }
+                    }
                  }
               else if (w < 0 && FATALERRNO)
                  LOG_ERROR;
               }
-           else {
-              PollTimeouts++;
-              if (PollTimeouts == POLLTIMEOUTS_BEFORE_DEVICECLEAR) {
-                 dsyslog("clearing device because of consecutive poll timeouts");
-                 DeviceClear();
-                 ringBuffer->Clear();
-                 remux->Clear();
-                 PlayPes(NULL, 0);
-                 p = NULL;
-                 }
+           else if (Refused.Elapsed() > DEVICECLEARTIMEOUT) {
+              dsyslog("clearing device because of consecutive poll timeouts");
+              Clear();
+              p = NULL;
               }
            }
+        else if (!b) {
+           // Wait until the receiver has delivered more data:
+           {
+             cMutexLock MutexLock(&stampMutex);
+             waiting = !ringBuffer->Available();
+           }
+           if (waiting)
+              newData.Wait(WAITTIMEOUT);
+           waiting = false;
+           }
         }
 }
 
@@ -123,3 +217,16 @@ cTransferControl::~cTransferControl()
   receiverDevice = NULL;
   delete transfer;
 }
+
+cString cTransferControl::Statistics(void)
+{
+  cMutexLock MutexLock(&TransferStatisticsMutex);
+  return cString::sprintf("latency: %s\nbacklog limit: %d KB\nclears: %d\n", *TransferLatency.ToString(), TransferBacklog / KILOBYTE(1), TransferClears);
+}
+
+void cTransferControl::ClearStatistics(void)
+{
+  cMutexLock MutexLock(&TransferStatisticsMutex);
+  TransferLatency.Clear();
+  TransferClears = 0;
+}
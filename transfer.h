@@ -16,10 +16,23 @@
 #include "ringbuffer.h"
 #include "thread.h"
 
+#define TRANSFERSTAMPS 64 // the maximum number of pending receive time stamps
+
 class cTransfer : public cReceiver, public cPlayer, public cThread {
 private:
+  struct tStamp { int64_t offset; uint64_t time; };
   cRingBufferLinear *ringBuffer;
   cRemux *remux;
+  cMutex stampMutex;
+  tStamp stamps[TRANSFERSTAMPS];
+  int firstStamp, numStamps;
+  int64_t received, remuxed;
+  cCondWait newData;
+  bool waiting;
+  int maxBacklog;
+  cTimeMs lastClear;
+  void Clear(void);
+  uint64_t StampTime(void);
 protected:
   virtual void Activate(bool On);
   virtual void Receive(uchar *Data, int Length);
@@ -38,6 +51,12 @@ public:
   ~cTransferControl();
   virtual void Hide(void) {}
   static cDevice *ReceiverDevice(void) { return receiverDevice; }
+  static cString Statistics(void);
+       ///< Returns the time (in ms) it took for data received in transfer mode to be
+       ///< handed to the output device, as well as the current limit for the amount
+       ///< of buffered data and the number of times the buffers had to be cleared.
+  static void ClearStatistics(void);
+       ///< Resets the statistics returned by Statistics().
   };
 
 #endif //__TRANSFER_H
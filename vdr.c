@@ -51,8 +51,10 @@
 #include "libsi/si.h"
 #include "lirc.h"
 #include "menu.h"
+#include "nulldevice.h"
 #include "osdbase.h"
 #include "plugin.h"
+#include "pretune.h"
 #include "rcu.h"
 #include "recording.h"
 #include "shutdown.h"
@@ -199,6 +201,7 @@ int main(int argc, char *argv[])
   const char *LocaleDir = NULL;
 
   bool UseKbd = true;
+  bool UseNullDevice = false;
   const char *LircDevice = NULL;
   const char *RcuDevice = NULL;
 #if !defined(REMOTE_KBD)
@@ -232,6 +235,7 @@ int main(int argc, char *argv[])
       { "log",      required_argument, NULL, 'l' },
       { "mute",     no_argument,       NULL, 'm' },
       { "no-kbd",   no_argument,       NULL, 'n' | 0x100 },
+      { "null-device", no_argument,    NULL, 'n' | 0x200 },
       { "plugin",   required_argument, NULL, 'P' },
       { "port",     required_argument, NULL, 'p' },
       { "rcu",      optional_argument, NULL, 'r' | 0x100 },
@@ -320,6 +324,9 @@ int main(int argc, char *argv[])
           case 'n' | 0x100:
                     UseKbd = false;
                     break;
+          case 'n' | 0x200:
+                    UseNullDevice = true;
+                    break;
           case 'p': if (isnumber(optarg))
                        SVDRPport = atoi(optarg);
                     else {
@@ -423,6 +430,8 @@ int main(int argc, char *argv[])
                "                           %s)\n"
                "  -m,       --mute         mute audio of the primary DVB device at startup\n"
                "            --no-kbd       don't use the keyboard as an input device\n"
+               "            --null-device  add a device that discards everything it is\n"
+               "                           given to play (for benchmarking replay)\n"
                "  -p PORT,  --port=PORT    use PORT for SVDRP (default: %d)\n"
                "                           0 turns off SVDRP\n"
                "  -P OPT,   --plugin=OPT   load a plugin defined by the given options\n"
@@ -605,6 +614,8 @@ int main(int argc, char *argv[])
   // DVB interfaces:
 
   cDvbDevice::Initialize();
+  if (UseNullDevice)
+     new cNullDevice;
 
   // Initialize plugins:
 
@@ -791,6 +802,11 @@ int main(int argc, char *argv[])
            LastChannel = cDevice::CurrentChannel();
            LastChannelChanged = Now;
            }
+        // EIT data that is still waiting for the next section:
+        cDevice::FlushEit();
+        // Predictive tuning:
+        if (!EITScanner.Active())
+           PreTuner.Process();
         if (Now - LastChannelChanged >= Setup.ZapTimeout && LastChannel != PreviousChannel[PreviousChannelIndex])
            PreviousChannel[PreviousChannelIndex ^= 1] = LastChannel;
         // Timers and Recordings:
@@ -1197,6 +1213,8 @@ int main(int argc, char *argv[])
              default:    break;
              }
            }
+        // Editing processes (queued ones must also be started while a menu is open):
+        cCutter::Process();
         if (!Menu) {
            if (!InhibitEpgScan)
               EITScanner.Process();
@@ -0,0 +1,170 @@
+/*
+ * zaptrace.c: Channel switch latency tracing
+ *
+ * See the main source file 'vdr.c' for copyright information and
+ * how to reach the author.
+ *
+ * $Id$
+ */
+
+#include "zaptrace.h"
+#include "device.h"
+#include "sources.h"
+
+enum eZapSource { zsSatellite, zsCable, zsTerrestrial, zsCount };
+
+static const char *ZapPhaseNames[zpCount] = { "device selection", "CAM assignment", "lock", "section handler", "PMT", "first video packet", "first I-frame" };
+static const char *ZapSourceNames[zsCount] = { "satellite", "cable", "terrestrial" };
+
+class cZapHistogram : public cHistogram {
+public:
+  cZapHistogram(void) : cHistogram(ZAPTRACEWINDOW) {}
+  };
+
+static cZapHistogram DevicePhases[MAXDEVICES][zpCount];
+static cZapHistogram SourcePhases[zsCount][zpCount];
+
+static int ZapSource(int Source)
+{
+  if (cSource::IsSat(Source))
+     return zsSatellite;
+  if (cSource::IsCable(Source))
+     return zsCable;
+  if (cSource::IsTerr(Source))
+     return zsTerrestrial;
+  return -1;
+}
+
+// --- cZapTrace -------------------------------------------------------------
+
+cMutex cZapTrace::mutex;
+cTimeMs cZapTrace::start;
+bool cZapTrace::active = false;
+int cZapTrace::cardIndex = -1;
+int cZapTrace::deviceNumber = -1;
+int cZapTrace::source = 0;
+int cZapTrace::transponder = 0;
+int cZapTrace::sid = 0;
+int cZapTrace::vpid = 0;
+int cZapTrace::done = 0;
+int cZapTrace::times[zpCount] = { 0 };
+volatile int cZapTrace::wantedVideo = -1;
+
+void cZapTrace::SetWantedVideo(void)
+{
+  // 'mutex' must be locked!
+  // Card index and PID are combined into one value, so that WantsPid() can
+  // check them without locking the mutex:
+  if (active && cardIndex >= 0 && vpid && !(done & (1 << zpVideo)))
+     wantedVideo = (cardIndex << 16) | vpid;
+  else
+     wantedVideo = -1;
+}
+
+void cZapTrace::Start(const cChannel *Channel)
+{
+  cMutexLock MutexLock(&mutex);
+  start.Set();
+  active = true;
+  cardIndex = deviceNumber = -1;
+  source = Channel->Source();
+  transponder = Channel->Transponder();
+  sid = Channel->Sid();
+  vpid = Channel->Vpid();
+  done = 0;
+  SetWantedVideo();
+}
+
+void cZapTrace::SetDevice(const cDevice *Device)
+{
+  cMutexLock MutexLock(&mutex);
+  if (active) {
+     if (Device) {
+        cardIndex = Device->CardIndex();
+        deviceNumber = Device->DeviceNumber();
+        // Now we know where to count the steps that have already been done:
+        if (0 <= deviceNumber && deviceNumber < MAXDEVICES) {
+           for (int i = 0; i < zpCount; i++) {
+               if (done & (1 << i))
+                  DevicePhases[deviceNumber][i].Add(times[i]);
+               }
+           }
+        }
+     else
+        active = false;
+     SetWantedVideo();
+     }
+}
+
+void cZapTrace::Add(eZapPhase Phase)
+{
+  // 'mutex' must be locked!
+  if (active) {
+     int Ms = int(start.Elapsed());
+     if (Ms > MAXZAPTIME) {
+        active = false; // this switch is over, whether or not all steps have been seen
+        SetWantedVideo();
+        return;
+        }
+     if (done & (1 << Phase))
+        return;
+     done |= 1 << Phase;
+     times[Phase] = Ms;
+     if (0 <= deviceNumber && deviceNumber < MAXDEVICES)
+        DevicePhases[deviceNumber][Phase].Add(Ms);
+     int t = ZapSource(source);
+     if (t >= 0)
+        SourcePhases[t][Phase].Add(Ms);
+     if (Phase == zpIFrame)
+        active = false; // the switch is complete
+     SetWantedVideo();
+     }
+}
+
+void cZapTrace::Mark(eZapPhase Phase, int CardIndex)
+{
+  cMutexLock MutexLock(&mutex);
+  if (CardIndex < 0 || CardIndex == cardIndex)
+     Add(Phase);
+}
+
+void cZapTrace::MarkPmt(int Source, int Transponder, int Sid)
+{
+  cMutexLock MutexLock(&mutex);
+  if (Source == source && ISTRANSPONDER(Transponder, transponder) && Sid == sid)
+     Add(zpPmt);
+}
+
+cString cZapTrace::Statistics(void)
+{
+  cMutexLock MutexLock(&mutex);
+  cString s = "";
+  for (int i = 0; i < MAXDEVICES; i++) {
+      for (int j = 0; j < zpCount; j++) {
+          if (DevicePhases[i][j].Count())
+             s = cString::sprintf("%sdevice %d %s: %s\n", *s, i + 1, ZapPhaseNames[j], *DevicePhases[i][j].ToString());
+          }
+      }
+  for (int i = 0; i < zsCount; i++) {
+      for (int j = 0; j < zpCount; j++) {
+          if (SourcePhases[i][j].Count())
+             s = cString::sprintf("%s%s %s: %s\n", *s, ZapSourceNames[i], ZapPhaseNames[j], *SourcePhases[i][j].ToString());
+          }
+      }
+  if (!**s)
+     s = "no channel switches recorded\n";
+  return s;
+}
+
+void cZapTrace::ClearStatistics(void)
+{
+  cMutexLock MutexLock(&mutex);
+  for (int i = 0; i < MAXDEVICES; i++) {
+      for (int j = 0; j < zpCount; j++)
+          DevicePhases[i][j].Clear();
+      }
+  for (int i = 0; i < zsCount; i++) {
+      for (int j = 0; j < zpCount; j++)
+          SourcePhases[i][j].Clear();
+      }
+}
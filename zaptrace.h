@@ -0,0 +1,84 @@
+/*
+ * zaptrace.h: Channel switch latency tracing
+ *
+ * See the main source file 'vdr.c' for copyright information and
+ * how to reach the author.
+ *
+ * $Id$
+ */
+
+#ifndef __ZAPTRACE_H
+#define __ZAPTRACE_H
+
+#include "channels.h"
+#include "thread.h"
+#include "tools.h"
+
+enum eZapPhase { zpDevice,   // a device has been selected in cDevice::GetDevice()
+                 zpCam,      // a CAM slot has been assigned to that device
+                 zpLock,     // the tuner has a lock
+                 zpSections, // the section handler has been restarted
+                 zpPmt,      // the PMT of the channel has been received
+                 zpVideo,    // the first video packet has been received
+                 zpIFrame,   // the first I-frame has been handed to the decoder
+                 zpCount
+               };
+
+class cDevice;
+
+/// The cZapTrace records how long it takes after a live channel switch until
+/// the individual steps of that switch are done. The times are counted since
+/// the beginning of the switch and are collected per device and per type of
+/// source. Only one channel switch is traced at a time, and steps that happen
+/// more than MAXZAPTIME ms after the switch has started are ignored.
+/// The first video packet can only be seen if the data is received through
+/// VDR itself (as in transfer mode), and the first I-frame only if it is
+/// actually replayed in transfer mode. A trace ends with the first I-frame,
+/// or with the first step that happens after MAXZAPTIME ms.
+/// The statistics are computed from the last ZAPTRACEWINDOW channel switches.
+
+#define MAXZAPTIME     10000 // ms
+#define ZAPTRACEWINDOW   100 // channel switches
+
+class cZapTrace {
+private:
+  static cMutex mutex;
+  static cTimeMs start;
+  static bool active;
+  static int cardIndex;
+  static int deviceNumber;
+  static int source;
+  static int transponder;
+  static int sid;
+  static int vpid;
+  static int done;
+  static int times[zpCount];
+  static volatile int wantedVideo;
+  static void Add(eZapPhase Phase);
+  static void SetWantedVideo(void);
+       ///< Determines which device and PID WantsPid() is waiting for.
+       ///< 'mutex' must be locked!
+public:
+  static void Start(const cChannel *Channel);
+       ///< Starts tracing a live channel switch to the given Channel.
+  static void SetDevice(const cDevice *Device);
+       ///< Tells the trace which Device is used for receiving the channel that
+       ///< is being switched to. If Device is NULL, the trace is discarded.
+  static void Mark(eZapPhase Phase, int CardIndex = -1);
+       ///< Records that the given Phase has been completed on the device with
+       ///< the given CardIndex (-1 if the device doesn't matter).
+  static void MarkPmt(int Source, int Transponder, int Sid);
+       ///< Records that the PMT of the given service has been received.
+  static bool WantsPid(int CardIndex, int Pid) { return wantedVideo == ((CardIndex << 16) | Pid); }
+       ///< Returns true if the given Pid of the device with the given CardIndex
+       ///< is the video PID the trace is waiting for. This is called for every
+       ///< TS packet and therefore doesn't lock the mutex.
+  static cString Statistics(void);
+       ///< Returns the times (in ms) from the beginning of a live channel switch
+       ///< until each step of that switch has been done, one line per device,
+       ///< source type and step.
+  static void ClearStatistics(void);
+       ///< Resets the statistics returned by Statistics().
+  };
+
+#endif //__ZAPTRACE_H